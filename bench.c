@@ -0,0 +1,145 @@
+#include "src/world.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*-- drops bodies onto the terrain headless and reports where the time went.
+
+   wip_bench [-n 1000,10000,50000] [-t ticks] [-json]
+
+   writes a csv row, or a json object, per body count to stdout. --*/
+
+// bodies are spaced this far apart on the drop grid
+#define bench_spacing 1.1f
+#define bench_drop_height 30.f
+
+typedef struct bench_run {
+  int n, ticks;
+  // summed over the ticks
+  double total, broad, integrate, solve, settle, objs;
+  long long pairs, moved;
+  int max_pairs, max_steps;
+  int asleep;
+} bench_run;
+
+// every 4th body is a capsule, the rest balls of a few sizes, laid out on a
+// square centered on the origin and stacked in a few layers
+static obj bench_body(int i, int n) {
+  int side = (int)ceilf(sqrtf((float)n));
+  float half = (float)side * bench_spacing / 2;
+  v3 pos = {
+    (float)(i % side) * bench_spacing - half,
+    bench_drop_height + (float)(i % 5) * 2,
+    (float)(i / side) * bench_spacing - half,
+  };
+  v3 vel = {0.01f * (float)(i % 3 - 1), 0, 0.01f * (float)(i % 5 - 2)};
+
+  obj o = test_new(pos, vel, 0.3f + 0.05f * (float)(i % 4));
+  if (i % 4 == 3) {
+    v3 axis = v3_normed((v3){(float)(i % 7) - 3, 2, (float)(i % 3) - 1});
+    o.body.cap = cap_new(axis, 0.25f, 0.3f);
+  }
+  return o;
+}
+
+static bench_run bench(int n, int ticks) {
+  world *w = world_new(hana_new());
+
+  // everything in draw range, generated up front so streaming isn't timed
+  world_stream(w, (iv2){});
+  chunk ch;
+  while (gen_wait(w->gen, &ch)) world_add_chunk(w, &ch);
+
+  for (int i = 0; i < n; i++) {
+    obj o = bench_body(i, n);
+    world_add_obj(w, &o);
+  }
+  arr_add_bulk(&w->objs_tick, w->objs_to_add);
+  arr_clear(w->objs_to_add);
+
+  bench_run r = {.n = n, .ticks = ticks};
+  for (int i = 0; i < ticks; i++) {
+    world_tick(w, v3_zero);
+    arr_add_bulk(&w->objs_tick, w->objs_to_add);
+    arr_clear(w->objs_to_add);
+
+    tick_stats *st = &w->stats;
+    r.broad += st->broad;
+    r.integrate += st->integrate;
+    r.solve += st->solve;
+    r.settle += st->settle;
+    r.objs += st->objs;
+    r.total += st->broad + st->integrate + st->solve + st->settle + st->objs;
+    r.pairs += st->n_pairs;
+    r.moved += st->n_moved;
+    r.max_pairs = max(r.max_pairs, st->n_pairs);
+    r.max_steps = max(r.max_steps, st->n_steps);
+  }
+
+  for (obj *o = w->objs_tick, *end = arr_end(w->objs_tick); o != end; o++) {
+    if (o->dynamic && o->proxy) r.asleep += grid_is_asleep(&w->grid, o->proxy);
+  }
+
+  // worlds aren't torn down, the process ends soon enough
+  return r;
+}
+
+static void bench_print(bench_run *r, bool json, bool last) {
+  double t = r->ticks;
+  if (!json) {
+    printf("%d,%d,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.1f,%d,%.1f,%d,%d\n",
+           r->n, r->ticks, r->total / t, r->broad / t, r->integrate / t,
+           r->solve / t, r->settle / t, r->objs / t, (double)r->pairs / t,
+           r->max_pairs, (double)r->moved / t, r->max_steps, r->asleep);
+    return;
+  }
+
+  printf("  {\"bodies\": %d, \"ticks\": %d, \"ms_per_tick\": {\"total\": %.4f, "
+         "\"broad\": %.4f, \"integrate\": %.4f, \"solve\": %.4f, "
+         "\"settle\": %.4f, \"objs\": %.4f}, \"pairs_avg\": %.1f, "
+         "\"pairs_max\": %d, \"moved_avg\": %.1f, \"steps_max\": %d, "
+         "\"asleep\": %d}%s\n",
+         r->n, r->ticks, r->total / t, r->broad / t, r->integrate / t,
+         r->solve / t, r->settle / t, r->objs / t, (double)r->pairs / t,
+         r->max_pairs, (double)r->moved / t, r->max_steps, r->asleep,
+         last ? "" : ",");
+}
+
+int main(int argc, char **argv) {
+  int counts[16] = {1000, 10000, 50000}, n_counts = 3, ticks = 600;
+  bool json = 0;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-json")) {
+      json = 1;
+    } else if (!strcmp(argv[i], "-t") && i + 1 < argc) {
+      ticks = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+      n_counts = 0;
+      for (char *s = strtok(argv[++i], ","); s && n_counts < 16;
+           s = strtok(NULL, ",")) {
+        counts[n_counts++] = atoi(s);
+      }
+    } else {
+      fprintf(stderr, "usage: %s [-n 1000,10000,50000] [-t ticks] [-json]\n",
+              argv[0]);
+      return 1;
+    }
+  }
+
+  if (json) {
+    printf("[\n");
+  } else {
+    printf("bodies,ticks,total_ms,broad_ms,integrate_ms,solve_ms,settle_ms,"
+           "objs_ms,pairs_avg,pairs_max,moved_avg,steps_max,asleep\n");
+  }
+
+  for (int i = 0; i < n_counts; i++) {
+    bench_run r = bench(counts[i], ticks);
+    bench_print(&r, json, i == n_counts - 1);
+    fflush(stdout);
+  }
+
+  if (json) printf("]\n");
+  return 0;
+}
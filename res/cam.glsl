@@ -0,0 +1,5 @@
+// the view-projection of the pass being drawn, written just before it draws.
+// see cam_vp_binding in gl.h
+layout (std140, row_major, binding = 0) uniform cam_vp {
+  mat4 u_vp;
+};
@@ -0,0 +1,71 @@
+// terrain vertex pulling, see ter_slot in view.h
+
+// chunk_size and chunk_qty in chunk.h, view_n_lods in view.h
+const float ter_size = 8.;
+const int ter_qty = 8;
+const int ter_len = ter_qty + 1;
+const int ter_n_lods = 4;
+
+struct ter_slot {
+  ivec2 pos;
+  int id;
+  int pad;
+  float h[ter_len * ter_len];
+  uint norm[ter_len * ter_len];
+};
+
+layout (std430, binding = 0) readonly buffer ter_slots {
+  ter_slot slots[];
+};
+
+uniform vec3 u_lod_eye;
+uniform float u_lod_range;
+uniform float u_lod_morph;
+
+struct ter_vtx {
+  vec3 pos;
+  vec3 norm;
+  int id;
+};
+
+int ter_lod_drop(int k) {
+  return k % ter_qty == 0 ? ter_n_lods : findLSB(k) + 1;
+}
+
+// blends a vertex onto the next level's grid as it nears the range where its
+// chunk stops drawing it. neighbours agree on shared edges since this only
+// depends on the vertex, so levels meet without cracks.
+float ter_morph(int s, int i, int j, vec3 pos) {
+  int lvl = min(ter_lod_drop(i), ter_lod_drop(j));
+  if (lvl >= ter_n_lods) return pos.y;
+
+  // dropped vertices sit mid-edge on the coarser grid, or mid-diagonal when
+  // both lines drop
+  int h = 1 << (lvl - 1);
+  int i0 = i, i1 = i, j0 = j, j1 = j;
+  if (((i / h) & 1) == 1) { i0 -= h; i1 += h; }
+  if (((j / h) & 1) == 1) { j0 -= h; j1 += h; }
+  float target = (slots[s].h[i0 * ter_len + j0] + slots[s].h[i1 * ter_len + j1]) * .5;
+
+  float end = u_lod_range * exp2(float(lvl - 1));
+  float band = end * u_lod_morph;
+  float t = clamp((distance(pos.xz, u_lod_eye.xz) - end + band) / band, 0., 1.);
+  return mix(pos.y, target, t);
+}
+
+// the draw's base vertex is slot * ter_len^2
+ter_vtx ter_pull() {
+  int s = gl_VertexID / (ter_len * ter_len);
+  int k = gl_VertexID % (ter_len * ter_len);
+  int i = k / ter_len, j = k % ter_len;
+
+  ter_vtx v;
+  v.pos.xz = vec2(slots[s].pos) * ter_size + vec2(i, j) * (ter_size / float(ter_qty));
+  v.pos.y = slots[s].h[k];
+  v.pos.y = ter_morph(s, i, j, v.pos);
+
+  vec2 e = unpackSnorm2x16(slots[s].norm[k]);
+  v.norm = normalize(vec3(e.x, 1. - abs(e.x) - abs(e.y), e.y));
+  v.id = slots[s].id;
+  return v;
+}
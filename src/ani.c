@@ -393,9 +393,8 @@ shdr *ani_mod_get_sh(draw_src s, cam *c, anime *a, mtl m, m4 t) {
 
   shdr *cur = s == ds_cam ? cam : shade;
 
-  shdr_m4f(cur, "u_vp", c->vp);
   shdr_3f(cur, "u_eye", cam_get_eye(c));
-  shdr_1f(cur, "u_time", app_now() / 1000.f);
+  shdr_1f(cur, "u_time", app_secs(wind_period));
   shdr_m4f(cur, "u_model", t);
   gl_program_uniform_matrix_4fv(cur->id, shdr_get_loc(cur, "u_final_mats"), 100, GL_TRUE, (float *)a->final_mats);
   shdr_3f(cur, "u_light_model", m.light_model);
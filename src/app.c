@@ -2,8 +2,8 @@
 #include "lib/glad/glad.h"
 #include "gl.h"
 #include "world.h"
+#include "view.h"
 #include "gui.h"
-#include <time.h>
 #include "pal.h"
 #include <pthread.h>
 
@@ -116,9 +116,15 @@ app app_new(int width, int height, const char *name) {
                         }),
     .mspf = avg_num_new(120), .mspt = avg_num_new(
       120), .mspd = avg_num_new(
-      120),
+      120), .mspl = avg_num_new(120),
+    .deferred = arr_new(input_ev),
     .world = world_new(hana_new()),
+    .view = view_new(),
+    .cam_vp = ubo_ring_new(sizeof(m4)),
+    .shade_vp = ubo_ring_new(sizeof(m4)),
     .player = 0,
+    .reach_id = -1,
+    .events = _new_((input_ring){}),
     .text = font_new((u8 *[fw_n]){
       [fw_reg] = read_bin_file("res/futura/futura-reg.ttf"),
       [fw_ita] = read_bin_file("res/futura/futura-ita.ttf"),
@@ -137,68 +143,69 @@ void app_setup_user_ptr(app *g) {
   glfw_set_window_user_pointer(g->glfw_win, g);
 }
 
-struct timespec timespec_diff(const struct timespec time1,
-                              const struct timespec time0) {
-  struct timespec diff = {
-    .tv_sec = time1.tv_sec - time0.tv_sec,
-    .tv_nsec = time1.tv_nsec - time0.tv_nsec
-  };
-
-  if (diff.tv_nsec < 0) {
-    diff.tv_nsec += 1000000000;
-    diff.tv_sec--;
-  }
+int64_t app_now() {
+  static int64_t start = -1;
+  if (start < 0) start = ticker_now();
 
-  return diff;
+  return ticker_now() - start;
 }
 
-float app_now() {
-  static struct timespec start;
-  static int first_run = 1;
-  if (first_run) {
-    clock_gettime(CLOCK_REALTIME, &start);
-    first_run = 0;
-  }
-
-  struct timespec ts;
-  clock_gettime(CLOCK_REALTIME, &ts);
+float app_secs(double period) {
+  return (float)fmod((double)app_now() / (double)ticker_ns_per_s, period);
+}
 
-  struct timespec diff = timespec_diff(ts, start);
-  auto res = (float)diff.tv_sec * 1e3f + (float)diff.tv_nsec / 1e6f;
+// ns as float ms, for the graphs. only for spans, never for app_now itself
+static float app_ms(int64_t ns) {
+  return (float)((double)ns / 1e6);
+}
 
-  return res;
+// the world only sees input through ctrl, so it never touches glfw
+static ctrl app_read_ctrl(app *a) {
+  v3 front = cam_dir(a->input.yaw, a->input.pitch);
+  return (ctrl){
+    .forwards = (float)(app_is_key_down(a, GLFW_KEY_W) -
+                        app_is_key_down(a, GLFW_KEY_S)),
+    .sideways = (float)(app_is_key_down(a, GLFW_KEY_D) -
+                        app_is_key_down(a, GLFW_KEY_A)),
+    .jump = app_is_key_down(a, GLFW_KEY_SPACE),
+    .throw = app_is_key_down(a, GLFW_KEY_T),
+    .front = front,
+    .right = v3_cross(front, a->cam.world_up),
+    .up = a->cam.world_up,
+  };
 }
 
 void app_tick(app *a) {
-  const float tick_len = 16.f; // 60 tps
-  static float last_frame_in_ticks = -10000.f;
-  static float prev_time_ms = -100000.f;
-
-  float time = app_now();
-  if (prev_time_ms < 0.f) prev_time_ms = time;
-  last_frame_in_ticks =
-    (time - prev_time_ms) / tick_len; // # of ticks it took to update last time
-  prev_time_ms = time;
-  a->dt += last_frame_in_ticks; // last_frame_in_ticks number of ticks have passed, add that to delta time
-  int i = (int)a->dt; // number of whole ticks that have passed, tick them
-
-  auto t_start = app_now();
-  for (int j = 0; j < min(i, 10); j++) {
-    world_tick(a->world, &a->cam);
+  int n = ticker_wait(&a->ticker);
+
+  int64_t t_start = app_now();
+  for (int j = 0; j < n; j++) {
+    // each tick sees the input up to the deadline it stands in for
+    int64_t due = a->ticker.next - (int64_t)(n - j) * a->ticker.period;
+    input_drain(a->events, &a->input, due);
+    a->world->ctrl = app_read_ctrl(a);
+    input_clear_taps(&a->input);
+
+    world_tick(a->world, a->world->objs_tick[a->player].body.pos);
     arr_add_bulk(&a->world->objs_tick, a->world->objs_to_add);
     arr_clear(a->world->objs_to_add);
 
-    pthread_mutex_lock(&a->world->draw_lock);
-    arr_copy(&a->world->objs, a->world->objs_tick);
-    world_cache(a->world,
-                world_get_chunk_pos(a->world->objs_tick[a->player].body.pos));
-    a->dt -= 1;
-    pthread_mutex_unlock(&a->world->draw_lock);
+    obj *player = &a->world->objs_tick[a->player];
+    query_hit reach;
+    world_cast(a->world, &(query){
+      .o = v3_add(player->body.pos, (v3){0, 0.75f, 0}),
+      .d = a->world->ctrl.front,
+      .l = app_reach,
+      .ignore = player->proxy,
+    }, &reach, 1);
+
+    iv2 center = world_get_chunk_pos(a->world->objs_tick[a->player].body.pos);
+    world_stream(a->world, center);
+    view_publish(a->view, a->world, center);
+    a->reach_id = reach.is_hit ? reach.id : -1;
   }
 
-  if (i) {
-    avg_num_add(&a->mspt, (app_now() - t_start));
-  }
+  avg_num_add(&a->mspt, app_ms(app_now() - t_start));
 }
 
 void *tick_runner(void *ap) {
@@ -233,6 +240,81 @@ void draw_graph(app *a, avg_num *v, v4 color, int bg) {
   arr_del(p);
 }
 
+// turns the camera towards the cursor at x, y and tells the tick thread.
+static void app_look(app *a, double x, double y) {
+  a->mouse = (v2){(float)x, (float)y};
+  cam_tick(&a->cam);
+  input_push(a->events, (input_ev){
+    .time = ticker_now(),
+    .kind = ik_look,
+    .yaw = a->cam.target_yaw,
+    .pitch = a->cam.target_pitch,
+  });
+}
+
+static void app_resize(app *k, int width, int height) {
+  k->dim = (v2){(float)width, (float)height};
+  k->lo_dim = (iv2){(int)(low_res * (float)width / (float)height),
+                    (int)low_res};
+  fbo_resize(&k->low_res, k->lo_dim.x, k->lo_dim.y, 1,
+             (u32[]){GL_COLOR_ATTACHMENT0});
+  fbo_resize(&k->low_res_2, k->lo_dim.x, k->lo_dim.y, 1,
+             (u32[]){GL_COLOR_ATTACHMENT0});
+  fbo_resize(&k->main, k->lo_dim.x * 2, k->lo_dim.y * 2, 2,
+             (u32[]){GL_COLOR_ATTACHMENT0, GL_DEPTH_ATTACHMENT});
+  k->cam.aspect = (float)width / (float)height;
+  gl_viewport(0, 0, width, height);
+}
+
+static void app_key(app *g, int keycode, int action) {
+  switch (keycode) {
+    case GLFW_KEY_ESCAPE:
+    case GLFW_KEY_GRAVE_ACCENT: {
+      if (action != GLFW_PRESS) break;
+      glfw_set_input_mode(g->glfw_win, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
+      g->is_mouse_captured = false;
+      g->cam.has_last = false;
+      break;
+    }
+    case GLFW_KEY_H: {
+      if (action != GLFW_PRESS) break;
+      g->is_rendering_halftone = !g->is_rendering_halftone;
+      break;
+    }
+  }
+}
+
+static void app_button(app *a, int keycode, int action) {
+  if (action == GLFW_RELEASE) {
+    win_rel(&a->win);
+  }
+
+  switch (keycode) {
+    case GLFW_MOUSE_BUTTON_LEFT: {
+      if (action != GLFW_PRESS) break;
+      if (win_click(&a->win, a->mouse)) break;
+      glfw_set_input_mode(a->glfw_win, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+      a->is_mouse_captured = true;
+      break;
+    }
+  }
+}
+
+// applies what the callbacks left during the last late latch, in order.
+static void app_replay(app *a) {
+  if (a->is_resized) {
+    app_resize(a, a->resized.x, a->resized.y);
+    a->is_resized = 0;
+  }
+
+  for (input_ev *ev = a->deferred; ev != arr_end(a->deferred); ev++) {
+    if (ev->kind == ik_key) app_key(a, ev->code, ev->action);
+    else app_button(a, ev->code, ev->action);
+  }
+
+  arr_clear(a->deferred);
+}
+
 void app_run(app *a) {
   app_setup_user_ptr(a);
   gl_depth_func(GL_LESS);
@@ -250,6 +332,14 @@ void app_run(app *a) {
   a->shade_cam.shade = 1;
   cam_rot(&a->shade_cam);
 
+  a->ticker = ticker_new(app_tick_rate);
+  a->input.yaw = a->cam.target_yaw;
+  a->input.pitch = a->cam.target_pitch;
+
+  // the renderer needs something to take before the first tick lands
+  view_publish(a->view, a->world,
+               world_get_chunk_pos(a->world->objs_tick[a->player].body.pos));
+
   pthread_t thread;
   pthread_create(&thread, NULL, tick_runner, a);
 
@@ -258,29 +348,38 @@ void app_run(app *a) {
 
   anime ani = anime_new(animation_new("res/cyl.dae", &a->cyl));
 
-  float frame_time = app_now();
+  int64_t frame_time = app_now(), latched = -1;
   while (!glfw_window_should_close(a->glfw_win)) {
-    auto start = app_now();
+    int64_t start = app_now();
     a->n_tris = 0;
 
-    float rdt = app_now() - frame_time;
+    float rdt = app_ms(app_now() - frame_time);
     frame_time = app_now();
 
+    app_replay(a);
+    glfw_poll_events();
+
     gl_enable(GL_DEPTH_TEST);
 
-    pthread_mutex_lock(&a->world->draw_lock);
-    float dt = a->dt;
+    // the tick thread never waits on this, it just publishes the next one
+    view_snap *snap = view_take(a->view);
+    float dt = fminf((float)(ticker_now() - snap->time) /
+                     (float)a->ticker.period, 1.f);
     anime_tick(&ani, rdt / 1000.f);
     gl_viewport(0, 0, shade_dim.x, shade_dim.y);
     fbo_bind(&a->shade);
     gl_clear(GL_DEPTH_BUFFER_BIT);
-    a->shade_cam.pos = v3_add(obj_get_ipos(&a->world->objs[a->player], dt),
+    a->shade_cam.pos = v3_add(obj_snap_ipos(&snap->objs[a->player], dt),
                               (v3){0, 0.75f, 0});
     cam_rot(&a->shade_cam);
+    *(m4 *)ubo_ring_next(&a->shade_vp) = a->shade_cam.vp;
+    ubo_ring_bind(&a->shade_vp, cam_vp_binding);
     gl_front_face(GL_CW);
-    world_draw(a->world, ds_shade, &a->shade_cam, dt);
+    view_cull(snap, ds_shade, &a->shade_cam, dt);
+    view_draw(a->view, snap, ds_shade, &a->shade_cam, dt);
     imod_draw(ds_shade, &a->shade_cam);
     ani_mod_draw(&a->cyl, &ani, ds_shade, &a->shade_cam, m4_ident, 0);
+    ubo_ring_fence(&a->shade_vp);
     gl_front_face(GL_CCW);
 
     {
@@ -301,20 +400,40 @@ void app_run(app *a) {
     gl_viewport(0, 0, a->lo_dim.x * 2, a->lo_dim.y * 2);
     fbo_bind(&a->main);
     gl_clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    a->cam.pos = v3_add(obj_get_ipos(&a->world->objs[a->player], dt),
+    a->cam.pos = v3_add(obj_snap_ipos(&snap->objs[a->player], dt),
                         (v3){0, 0.75f, 0});
     cam_rot(&a->cam);
-    world_draw(a->world, ds_cam, &a->cam, dt);
+    view_cull(snap, ds_cam, &a->cam, dt);
+
+    // late latch: events are polled again so mouse look that came in during
+    // the shadow pass and culling makes it into this frame's camera pass.
+    // resizes, keys and buttons wait for app_replay at the top of the next
+    m4 *vp = ubo_ring_next(&a->cam_vp);
+    float yaw = a->cam.target_yaw, pitch = a->cam.target_pitch;
+    v2 mouse = a->mouse;
+    a->is_latching = 1;
+    glfw_poll_events();
+    a->is_latching = 0;
+    cam_latch(&a->cam, yaw, pitch);
+
+    // motion picked up here would otherwise have waited for the next latch
+    int64_t now = app_now();
+    if (latched >= 0) avg_num_add(&a->mspl, app_ms(now - latched));
+    latched = a->mouse.x != mouse.x || a->mouse.y != mouse.y ? now : -1;
+    *vp = a->cam.vp;
+    ubo_ring_bind(&a->cam_vp, cam_vp_binding);
+
+    view_draw(a->view, snap, ds_cam, &a->cam, dt);
     imod_draw(ds_cam, &a->cam);
     ani_mod_draw(&a->cyl, &ani, ds_cam, &a->cam, m4_ident, 0);
-    pthread_mutex_unlock(&a->world->draw_lock);
+    ubo_ring_fence(&a->cam_vp);
 
-    // raycast to get id in player's reach
+    // outline what the player can reach, a->reach_id
 
     gl_enable(GL_BLEND);
 
 //    shdr_bind(&a->outline);
-//    shdr_1i(&a->outline, "u_id", id);
+//    shdr_1i(&a->outline, "u_id", a->reach_id);
 //    tex_bind(fbo_tex_at(&a->main, GL_COLOR_ATTACHMENT1), 0);
 //    shdr_1i(&a->outline, "u_tex", 0);
 //
@@ -367,10 +486,11 @@ void app_run(app *a) {
               a->cam.pos.z);
     font_draw(&a->text, text_buf, (v2){20, 20}, 0xffffffff, 1, 1.f);
     sprintf_s(text_buf, 128,
-              "&bmsp&r(&bt&r/&bf&r/&bd&r): &b%.3f&r/&b%.3f/&b%.3f",
+              "&bmsp&r(&bt&r/&bf&r/&bd&r/&bl&r): &b%.3f&r/&b%.3f/&b%.3f/&b%.3f",
               avg_num_get(&a->mspt),
               avg_num_get(&a->mspf),
-              avg_num_get(&a->mspd));
+              avg_num_get(&a->mspd),
+              avg_num_get(&a->mspl));
     font_draw(&a->text, text_buf, (v2){20, 20 + a->text.size}, 0xffffffff,
               1, 1.f);
     sprintf_s(text_buf, 128, "&bworld size&r: &b%zu&r/&b%zu",
@@ -378,7 +498,7 @@ void app_run(app *a) {
               a->world->chunks.cap);
     font_draw(&a->text, text_buf, (v2){20, 20 + a->text.size * 2},
               0xffffffff, 1, 1.f);
-    sprintf_s(text_buf, 128, "&b# objects&r: &b%zu", arr_len(a->world->objs));
+    sprintf_s(text_buf, 128, "&b# objects&r: &b%zu", arr_len(snap->objs));
     font_draw(&a->text, text_buf, (v2){20, 20 + a->text.size * 3},
               0xffffffff, 1, 1.f);
     sprintf_s(text_buf, 128, "&bculled&r: &b%.2f%%&r",
@@ -393,15 +513,14 @@ void app_run(app *a) {
     draw_graph(a, &a->mspd, (v4){1.f, 0.f, 1.f, 1.f}, 0);
     draw_graph(a, &a->mspt, (v4){0.f, 1.f, 1.f, 1.f}, 0);
 
-    avg_num_add(&a->mspd, (app_now() - start));
+    avg_num_add(&a->mspd, app_ms(app_now() - start));
 
     if (!a->is_mouse_captured) {
       win_draw(&a->win);
     }
 
     glfw_swap_buffers(a->glfw_win);
-    avg_num_add(&a->mspf, (app_now() - start));
-    glfw_poll_events();
+    avg_num_add(&a->mspf, app_ms(app_now() - start));
 
     arena_reset(&$.temp);
   }
@@ -412,69 +531,54 @@ void app_cleanup(app *g) {
 }
 
 bool app_is_key_down(app *g, int key) {
-  return glfw_get_key(g->glfw_win, key) == GLFW_PRESS;
+  return input_is_down(&g->input, key);
 }
 
 /*-- glfw callbacks --*/
 
 void framebuffer_size_callback(GLFWwindow *win, int width, int height) {
   app *k = glfw_get_window_user_pointer(win);
-  k->dim = (v2){(float)width, (float)height};
-  k->lo_dim = (iv2){(int)(low_res * (float)width / (float)height),
-                    (int)low_res};
-  fbo_resize(&k->low_res, k->lo_dim.x, k->lo_dim.y, 1,
-             (u32[]){GL_COLOR_ATTACHMENT0});
-  fbo_resize(&k->low_res_2, k->lo_dim.x, k->lo_dim.y, 1,
-             (u32[]){GL_COLOR_ATTACHMENT0});
-  fbo_resize(&k->main, k->lo_dim.x * 2, k->lo_dim.y * 2, 2,
-             (u32[]){GL_COLOR_ATTACHMENT0, GL_DEPTH_ATTACHMENT});
-  k->cam.aspect = (float)width / (float)height;
-  gl_viewport(0, 0, width, height);
+  if (k->is_latching) {
+    k->is_resized = 1;
+    k->resized = (iv2){width, height};
+    return;
+  }
+
+  app_resize(k, width, height);
 }
 
 void cursor_pos_callback(GLFWwindow *win, double xpos, double ypos) {
-  app *k = glfw_get_window_user_pointer(win);
-  k->mouse = (v2){(float)xpos, (float)ypos};
-  cam_tick(&k->cam);
+  app_look(glfw_get_window_user_pointer(win), xpos, ypos);
 }
 
 void
 key_callback(GLFWwindow *win, int keycode, int scancode, int action, int mods) {
   app *g = glfw_get_window_user_pointer(win);
-  switch (keycode) {
-    case GLFW_KEY_ESCAPE:
-    case GLFW_KEY_GRAVE_ACCENT: {
-      if (action != GLFW_PRESS) break;
-      glfw_set_input_mode(win, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
-      g->is_mouse_captured = false;
-      g->cam.has_last = false;
-      break;
-    }
-    case GLFW_KEY_H: {
-      if (action != GLFW_PRESS) break;
-      g->is_rendering_halftone = !g->is_rendering_halftone;
-      break;
-    }
-  }
+  input_ev ev = {
+    .time = ticker_now(),
+    .kind = ik_key,
+    .code = keycode,
+    .action = action,
+  };
+
+  input_push(g->events, ev);
+  if (g->is_latching) arr_add(&g->deferred, &ev);
+  else app_key(g, keycode, action);
 }
 
 void
 mouse_button_callback(GLFWwindow *win, int keycode, int action, int mods) {
   app *a = glfw_get_window_user_pointer(win);
+  input_ev ev = {
+    .time = ticker_now(),
+    .kind = ik_button,
+    .code = keycode,
+    .action = action,
+  };
 
-  if (action == GLFW_RELEASE) {
-    win_rel(&a->win);
-  }
-
-  switch (keycode) {
-    case GLFW_MOUSE_BUTTON_LEFT: {
-      if (action != GLFW_PRESS) break;
-      if (win_click(&a->win, a->mouse)) break;
-      glfw_set_input_mode(win, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-      a->is_mouse_captured = true;
-      break;
-    }
-  }
+  input_push(a->events, ev);
+  if (a->is_latching) arr_add(&a->deferred, &ev);
+  else app_button(a, keycode, action);
 }
 
 void
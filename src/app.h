@@ -7,11 +7,19 @@
 #include "err.h"
 #include "gl.h"
 #include "world.h"
+#include "view.h"
 #include "text.h"
 #include "gui.h"
 #include "avg.h"
 #include "arena.h"
 #include "ani.h"
+#include "ticker.h"
+#include "input.h"
+
+// how far the player can reach, from the eyes
+#define app_reach 4.f
+// ticks a second
+#define app_tick_rate 60
 
 typedef struct app {
   v2 dim;
@@ -20,14 +28,30 @@ typedef struct app {
   vao post;
   shdr dither, blit, crt, outline;
   cam cam, shade_cam;
+  // u_vp of the camera pass, written by cam_latch right before it's issued,
+  // and of the shadow pass
+  ubo_ring cam_vp, shade_vp;
   fbo low_res, low_res_2, main, shade;
   world *world;
+  view *view;
   bool is_mouse_captured, is_rendering_halftone;
-  float dt;
-  avg_num mspt, mspf, mspd;
+  // paces the tick thread. set before it starts, then only it touches next
+  ticker ticker;
+  // pushed by the glfw callbacks, drained by the tick thread into input
+  input_ring *events;
+  input_state input;
+  // set while the late latch polls. callbacks that would touch what the frame
+  // is using leave it in resized and deferred for app_replay instead
+  bool is_latching, is_resized;
+  iv2 resized;
+  input_ev *deferred;
+  // mspl is how much sooner the late latch shows the motion it picks up
+  avg_num mspt, mspf, mspd, mspl;
   text text;
   win win;
   int player;
+  // id of what the player is looking at within app_reach, -1 for nothing
+  int _Atomic reach_id;
   arena temp;
   mod ball;
   ani_mod cyl;
@@ -50,6 +74,7 @@ void app_cleanup(app *g);
 
 void app_setup_user_ptr(app *g);
 
+// as of the input the tick thread last drained, so only call it from there.
 bool app_is_key_down(app *g, int key);
 
 void framebuffer_size_callback(GLFWwindow *win, int width, int height);
@@ -65,4 +90,9 @@ void
 gl_error_callback(u32 source, u32 type, u32 id, u32 severity, int length,
                   char const *message, void const *user_param);
 
-float app_now();
\ No newline at end of file
+// ns since the app started. take differences, don't convert the whole thing.
+int64_t app_now();
+
+// seconds since the app started, wrapped to period so the float keeps its
+// precision however long the app runs.
+float app_secs(double period);
\ No newline at end of file
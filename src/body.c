@@ -4,8 +4,18 @@
 #include "arr.h"
 #include "box.h"
 #include <stddef.h>
-#include "gl.h"
 #include "chunk.h"
+#include "simd.h"
+#include "dda.h"
+
+#define bvh_leaf_size 4
+#define bvh_bins 12
+// deeper subtrees are left as leaves, bounding the traversal stacks
+#define bvh_max_depth 48
+// how far past a face tri_toi lets a body go, as a fraction of its radius
+#define toi_overshoot 0.1f
+// how far a body can move before its tri_cache is refilled
+#define tri_cache_margin 0.25f
 
 void body_response(body *b, hit h, float slip) {
   b->pos = v3_add(b->pos, v3_mul(h.norm, h.push));
@@ -42,69 +52,107 @@ v3 point_line_closest(v3 a, v3 b, v3 p) {
   return v3_add(a, v3_mul(ab, clamp(t, 0.f, 1.f)));
 }
 
-hit hit_tb(tri t, body *ball_obj) {
-  v3 A = t.pos[0], B = t.pos[1], C = t.pos[2];
-  ball b = ball_obj->ball;
-  v3 b_pos = ball_obj->pos;
-  float dist = v3_dot(v3_sub(b_pos, A), t.norm);
-  if (dist < -b.rad || dist > b.rad) return hit_miss;
-
-  v3 p0 = v3_sub(b_pos, v3_mul(t.norm, dist));
-  v3 c0 = v3_cross(v3_sub(p0, A), v3_sub(B, A));
-  v3 c1 = v3_cross(v3_sub(p0, B), v3_sub(C, B));
-  v3 c2 = v3_cross(v3_sub(p0, C), v3_sub(A, C));
-
-  int inside = v3_dot(c0, t.norm) <= 0 && v3_dot(c1, t.norm) <= 0 &&
-               v3_dot(c2, t.norm) <= 0;
-
-  float rad_sq = b.rad * b.rad;
-
-  // edge 1
-  v3 p1 = point_line_closest(A, B, b_pos);
-  v3 v1 = v3_sub(b_pos, p1);
-  float dist_sq1 = v3_dot(v1, v1);
-  int intersects = dist_sq1 < rad_sq;
-
-  // edge 2
-  v3 p2 = point_line_closest(B, C, b_pos);
-  v3 v2 = v3_sub(b_pos, p2);
-  float dist_sq2 = v3_dot(v2, v2);
-  intersects |= dist_sq2 < rad_sq;
-
-  // edge 3
-  v3 p3 = point_line_closest(C, A, b_pos);
-  v3 v3 = v3_sub(b_pos, p3);
-  float dist_sq3 = v3_dot(v3, v3);
-  intersects |= dist_sq3 < rad_sq;
-
-  if (!inside && !intersects) return hit_miss;
-
-  union v3 norm;
-
-  if (inside) {
-    norm = v3_sub(b_pos, p0);
-  } else {
-    float best_sq = dist_sq1;
-    norm = v1;
-
-    if (dist_sq2 < best_sq) {
-      best_sq = dist_sq2;
-      norm = v2;
-    }
+// up to 8 triangles, a component per vector. lanes past n are ignored
+typedef struct tri8 {
+  f8 ax, ay, az, bx, by, bz, cx, cy, cz, nx, ny, nz;
+  int n;
+} tri8;
+
+static void tri8_add(tri8 *b, tri *t) {
+  int i = b->n++;
+  b->ax[i] = t->pos[0].x, b->ay[i] = t->pos[0].y, b->az[i] = t->pos[0].z;
+  b->bx[i] = t->pos[1].x, b->by[i] = t->pos[1].y, b->bz[i] = t->pos[1].z;
+  b->cx[i] = t->pos[2].x, b->cy[i] = t->pos[2].y, b->cz[i] = t->pos[2].z;
+  b->nx[i] = t->norm.x, b->ny[i] = t->norm.y, b->nz[i] = t->norm.z;
+}
 
-    if (dist_sq3 < best_sq) {
-      norm = v3;
-    }
+// the closest point to p on each lane's segment a b
+static void seg8_closest(f8 ax, f8 ay, f8 az, f8 bx, f8 by, f8 bz,
+                         f8 px, f8 py, f8 pz, f8 *ox, f8 *oy, f8 *oz) {
+  f8 abx = bx - ax, aby = by - ay, abz = bz - az;
+  f8 t = ((px - ax) * abx + (py - ay) * aby + (pz - az) * abz) /
+         (abx * abx + aby * aby + abz * abz);
+  t = f8_clamp01(t);
+  *ox = ax + abx * t, *oy = ay + aby * t, *oz = az + abz * t;
+}
+
+// whether each lane's p, on its triangle's plane, is inside all three edges
+static i8 tri8_contains(tri8 *t, f8 px, f8 py, f8 pz) {
+  f8 const *x[] = {&t->ax, &t->bx, &t->cx}, *y[] = {&t->ay, &t->by, &t->cy},
+    *z[] = {&t->az, &t->bz, &t->cz};
+
+  i8 inside = (i8){} - 1;
+  for (int k = 0; k < 3; k++) {
+    int l = (k + 1) % 3;
+    f8 dx = px - *x[k], dy = py - *y[k], dz = pz - *z[k];
+    f8 ex = *x[l] - *x[k], ey = *y[l] - *y[k], ez = *z[l] - *z[k];
+    f8 cx = dy * ez - dz * ey, cy = dz * ex - dx * ez, cz = dx * ey - dy * ex;
+    inside &= cx * t->nx + cy * t->ny + cz * t->nz <= 0;
   }
 
-  float len = v3_len(norm);
-  v3_norm(&norm);
-  float depth = b.rad - len;
-  return (hit){
-    .is_hit = 1,
-    .norm = norm,
-    .push = depth
-  };
+  return inside;
+}
+
+// adds the push out of every triangle in t for balls of radius rad centered at
+// p, a center per lane. lanes add up in order, like one triangle at a time
+static void hit_tb8(tri8 *t, f8 px, f8 py, f8 pz, float rad, v3 *total) {
+  f8 dist = (px - t->ax) * t->nx + (py - t->ay) * t->ny + (pz - t->az) * t->nz;
+  // written so nans count as near
+  i8 near = ~((dist < -rad) | (dist > rad));
+
+  f8 p0x = px - t->nx * dist, p0y = py - t->ny * dist, p0z = pz - t->nz * dist;
+  i8 inside = tri8_contains(t, p0x, p0y, p0z);
+
+  // the closest edge, in order, ties going to the earlier one
+  f8 const *x[] = {&t->ax, &t->bx, &t->cx}, *y[] = {&t->ay, &t->by, &t->cy},
+    *z[] = {&t->az, &t->bz, &t->cz};
+  f8 best_sq = {}, vx = {}, vy = {}, vz = {};
+  for (int k = 0; k < 3; k++) {
+    int l = (k + 1) % 3;
+    f8 ex, ey, ez;
+    seg8_closest(*x[k], *y[k], *z[k], *x[l], *y[l], *z[l], px, py, pz,
+                 &ex, &ey, &ez);
+    ex = px - ex, ey = py - ey, ez = pz - ez;
+    f8 dist_sq = ex * ex + ey * ey + ez * ez;
+
+    i8 closer = k ? dist_sq < best_sq : (i8){} - 1;
+    best_sq = f8_select(closer, dist_sq, best_sq);
+    vx = f8_select(closer, ex, vx);
+    vy = f8_select(closer, ey, vy);
+    vz = f8_select(closer, ez, vz);
+  }
+
+  i8 is_hit = near & (inside | (best_sq < rad * rad)) &
+              ((i8){0, 1, 2, 3, 4, 5, 6, 7} < t->n);
+  int mask = 0;
+  for (int i = 0; i < simd_width; i++) mask |= (is_hit[i] & 1) << i;
+  if (!mask) return;
+
+  vx = f8_select(inside, px - p0x, vx);
+  vy = f8_select(inside, py - p0y, vy);
+  vz = f8_select(inside, pz - p0z, vz);
+
+  f8 len = f8_sqrt(vx * vx + vy * vy + vz * vz);
+
+  // centered on the face, as when a capsule's axis pierces it
+  i8 flat = len < 0.00001f;
+  vx = f8_select(flat, t->nx, vx / len);
+  vy = f8_select(flat, t->ny, vy / len);
+  vz = f8_select(flat, t->nz, vz / len);
+  f8 push = rad - f8_select(flat, f8_set(0), len);
+
+  vx *= push, vy *= push, vz *= push;
+  for (int i = 0; i < simd_width; i++) {
+    if (mask >> i & 1) *total = v3_add(*total, (v3){vx[i], vy[i], vz[i]});
+  }
+}
+
+// adds the hits of a batch of triangles with o to total
+typedef void (*tri_fn)(tri8 *t, body *o, v3 *total);
+
+static void hit_tb(tri8 *t, body *ball_obj, v3 *total) {
+  v3 p = ball_obj->pos;
+  hit_tb8(t, f8_set(p.x), f8_set(p.y), f8_set(p.z), ball_obj->ball.rad, total);
 }
 
 hit hit_c(body *cap_a, body *cap_b) {
@@ -149,110 +197,206 @@ hit hit_bc(body *ball_obj, body *cap_obj) {
   return hit_b(&(body){.ball = ball_new(b.rad), .pos = best_p}, ball_obj);
 }
 
-hit hit_tc(tri t, body *cap_obj) {
-  v3 A = t.pos[0], B = t.pos[1], C = t.pos[2];
+// each lane's capsule axis meets the plane of its triangle, or the closest
+// point on the triangle to there. the ball at the point on the axis closest
+// to that is what hits
+static void hit_tc(tri8 *t, body *cap_obj, v3 *total) {
   cap c = cap_obj->cap;
   v3 c_pos = cap_obj->pos;
-
   v3 a = v3_add(c_pos, v3_mul(c.norm, c.ext));
   v3 b = v3_sub(c_pos, v3_mul(c.norm, c.ext));
 
-  float T = v3_dot(t.norm, v3_div(v3_sub(A, c_pos),
-                                  fabsf(v3_dot(t.norm, c.norm))));
-  v3 line_plane_intersection = v3_add(c_pos, v3_mul(c.norm, T));
-
-  v3 ref_point;
-
-  // Determine whether line_plane_intersection is inside all triangle edges:
-  v3 c0 = v3_cross(v3_sub(line_plane_intersection, A),
-                    v3_sub(B, A));
-  v3 c1 = v3_cross(v3_sub(line_plane_intersection, B),
-                    v3_sub(C, B));
-  v3 c2 = v3_cross(v3_sub(line_plane_intersection, C),
-                    v3_sub(A, C));
-  int inside = v3_dot(c0, t.norm) <= 0 && v3_dot(c1, t.norm) <= 0 &&
-               v3_dot(c2, t.norm) <= 0;
-
-  if (inside) {
-    ref_point = line_plane_intersection;
-  } else {
-    // Edge 1:
-    v3 point1 = point_line_closest(A, B,
-                                    line_plane_intersection);
-    v3 v1 = v3_sub(line_plane_intersection, point1);
-    float distsq = v3_dot(v1, v1);
-    float best_dist = distsq;
-    ref_point = point1;
-
-    // Edge 2:
-    v3 point2 = point_line_closest(B, C,
-                                    line_plane_intersection);
-    v3 v2 = v3_sub(line_plane_intersection, point2);
-    distsq = v3_dot(v2, v2);
-    if (distsq < best_dist) {
-      ref_point = point2;
-      best_dist = distsq;
-    }
-
-    // Edge 3:
-    v3 point3 = point_line_closest(C, A,
-                                    line_plane_intersection);
-    v3 v3 = v3_sub(line_plane_intersection, point3);
-    distsq = v3_dot(v3, v3);
-    if (distsq < best_dist) {
-      ref_point = point3;
-    }
+  f8 n_dot = t->nx * c.norm.x + t->ny * c.norm.y + t->nz * c.norm.z;
+  f8 along = f8_abs(n_dot);
+  f8 T = t->nx * ((t->ax - c_pos.x) / along) +
+         t->ny * ((t->ay - c_pos.y) / along) +
+         t->nz * ((t->az - c_pos.z) / along);
+  f8 lx = c_pos.x + c.norm.x * T, ly = c_pos.y + c.norm.y * T,
+    lz = c_pos.z + c.norm.z * T;
+
+  i8 inside = tri8_contains(t, lx, ly, lz);
+
+  f8 const *x[] = {&t->ax, &t->bx, &t->cx}, *y[] = {&t->ay, &t->by, &t->cy},
+    *z[] = {&t->az, &t->bz, &t->cz};
+  f8 best_sq = {}, rx = lx, ry = ly, rz = lz;
+  for (int k = 0; k < 3; k++) {
+    int l = (k + 1) % 3;
+    f8 ex, ey, ez;
+    seg8_closest(*x[k], *y[k], *z[k], *x[l], *y[l], *z[l], lx, ly, lz,
+                 &ex, &ey, &ez);
+    f8 dx = lx - ex, dy = ly - ey, dz = lz - ez;
+    f8 dist_sq = dx * dx + dy * dy + dz * dz;
+
+    i8 closer = ~inside & (k ? dist_sq < best_sq : (i8){} - 1);
+    best_sq = f8_select(closer, dist_sq, best_sq);
+    rx = f8_select(closer, ex, rx);
+    ry = f8_select(closer, ey, ry);
+    rz = f8_select(closer, ez, rz);
   }
 
-  v3 center = point_line_closest(a, b, ref_point);
-
-  return hit_tb(t, &(body){.ball = ball_new(c.rad), .pos = center});
+  f8 px, py, pz;
+  seg8_closest(f8_set(a.x), f8_set(a.y), f8_set(a.z),
+               f8_set(b.x), f8_set(b.y), f8_set(b.z), rx, ry, rz,
+               &px, &py, &pz);
+  hit_tb8(t, px, py, pz, c.rad, total);
 }
 
-hit hit_mb(body *tmesh_obj, body *ball_obj) {
-  tmesh m = tmesh_obj->mesh;
-  v3 total = v3_zero;
-  for (tri *b = m.tris, *end = arr_end(m.tris); b != end; b++) {
-    if (!box3_overlaps(b->box, body_get_box(ball_obj))) continue;
-    hit h = hit_tb(*b, ball_obj);
+// queues t for o, testing the batch once it's full
+static void tri8_push(tri8 *batch, tri *t, body *o, tri_fn hit_t, v3 *total) {
+  tri8_add(batch, t);
+  if (batch->n < simd_width) return;
 
-    total = v3_add(total, v3_mul(h.norm, h.push));
-  }
+  hit_t(batch, o, total);
+  batch->n = 0;
+}
 
+static hit hit_total(v3 total) {
   float push = v3_len(total);
 
   if (push < 0.00001) return hit_miss;
 
-  v3 norm = v3_div(total, push);
-
   return (hit){
     .is_hit = 1,
-    .norm = norm,
+    .norm = v3_div(total, push),
     .push = push
   };
 }
 
-hit hit_mc(body *tmesh_obj, body *cap_obj) {
-  tmesh m = tmesh_obj->mesh;
-  v3 total = v3_zero;
-  for (tri *b = m.tris, *end = arr_end(m.tris); b != end; b++) {
-    if (!box3_overlaps(b->box, body_get_box(cap_obj))) continue;
-    hit h = hit_tc(*b, cap_obj);
+hfield hfield_new(v3 origin, float cell, int n, float *h) {
+  float lo = 1e20f, hi = -1e20f;
+  for (int i = 0, size = arr_len(h); i < size; i++) {
+    lo = min(lo, h[i]);
+    hi = max(hi, h[i]);
+  }
 
-    total = v3_add(total, v3_mul(h.norm, h.push));
+  return (hfield){
+    .type = bt_height,
+    .origin = origin,
+    .cell = cell,
+    .n = n,
+    .h = h,
+    .box = box3_new((v3){origin.x, lo, origin.z},
+                    (v3){origin.x + cell * n, hi, origin.z + cell * n}),
+  };
+}
+
+// the two triangles of cell (i, j), wound like quad_indices
+static void hfield_cell(hfield *f, int i, int j, tri out[2]) {
+  int w = f->n + 1;
+  float x0 = f->origin.x + f->cell * i, z0 = f->origin.z + f->cell * j;
+  v3 p00 = {x0, f->h[i * w + j], z0},
+    p01 = {x0, f->h[i * w + j + 1], z0 + f->cell},
+    p10 = {x0 + f->cell, f->h[(i + 1) * w + j], z0},
+    p11 = {x0 + f->cell, f->h[(i + 1) * w + j + 1], z0 + f->cell};
+
+  out[0] = tri_new(p11, p10, p00,
+                   v3_normed(v3_cross(v3_sub(p10, p11), v3_sub(p00, p11))));
+  out[1] = tri_new(p00, p01, p11,
+                   v3_normed(v3_cross(v3_sub(p01, p00), v3_sub(p11, p00))));
+}
+
+// the cells under box, inclusive
+static void hfield_range(hfield *f, box3 box, int *i0, int *i1, int *j0,
+                         int *j1) {
+  float inv = 1.f / f->cell;
+  *i0 = max((int)floorf((box.min.x - f->origin.x) * inv), 0);
+  *i1 = min((int)floorf((box.max.x - f->origin.x) * inv), f->n - 1);
+  *j0 = max((int)floorf((box.min.z - f->origin.z) * inv), 0);
+  *j1 = min((int)floorf((box.max.z - f->origin.z) * inv), f->n - 1);
+}
+
+// whether a walk goes into a node or triangle with box b
+typedef bool (*tri_in_fn)(box3 b, void *ctx);
+// what's done with each triangle a walk reaches, returning 1 stops it
+typedef bool (*tri_visit_fn)(tri *t, void *ctx);
+
+// for walks after whatever overlaps a box, which their ctx starts with
+static bool tri_in_box(box3 b, void *ctx) {
+  return box3_overlaps(b, *(box3 *)ctx);
+}
+
+// walks m's tree into every node that passes in, and visits the triangles
+// that pass too in the leaves it reaches. returns 1 if visit stopped it
+static bool bvh_visit(tmesh *m, tri_in_fn in, tri_visit_fn visit, void *ctx) {
+  int stack[bvh_max_depth + 2], top = 0;
+  if (!arr_is_empty(m->nodes)) stack[top++] = 0;
+  while (top) {
+    int idx = stack[--top];
+    bvh_node *n = &m->nodes[idx];
+    if (!in(n->box, ctx)) continue;
+
+    if (!n->count) {
+      stack[top++] = n->first;
+      stack[top++] = idx + 1;
+      continue;
+    }
+
+    for (tri *t = &m->tris[n->first], *end = t + n->count; t != end; t++) {
+      if (in(t->box, ctx) && visit(t, ctx)) return 1;
+    }
   }
 
-  float push = v3_len(total);
+  return 0;
+}
 
-  if (push < 0.00001) return hit_miss;
+// visits the triangles of the cells under box that overlap it, so the cost
+// only depends on how big box is. returns 1 if visit stopped it
+static bool hfield_visit(hfield *f, box3 box, tri_visit_fn visit, void *ctx) {
+  int i0, i1, j0, j1;
+  hfield_range(f, box, &i0, &i1, &j0, &j1);
 
-  v3 norm = v3_div(total, push);
+  for (int i = i0; i <= i1; i++) {
+    for (int j = j0; j <= j1; j++) {
+      tri t[2];
+      hfield_cell(f, i, j, t);
 
-  return (hit){
-    .is_hit = 1,
-    .norm = norm,
-    .push = push
-  };
+      for (int k = 0; k < 2; k++) {
+        if (box3_overlaps(t[k].box, box) && visit(&t[k], ctx)) return 1;
+      }
+    }
+  }
+
+  return 0;
+}
+
+// visits the triangles of a static body that overlap the box ctx starts with
+static bool sta_visit(body *sta, tri_visit_fn visit, void *ctx) {
+  switch (sta->type) {
+    case bt_mesh: return bvh_visit(&sta->mesh, tri_in_box, visit, ctx);
+    case bt_height: return hfield_visit(&sta->height, *(box3 *)ctx, visit, ctx);
+    default: return 0;
+  }
+}
+
+typedef struct tri_hits {
+  box3 box;
+  body *o;
+  tri_fn hit_t;
+  tri8 batch;
+  v3 total;
+} tri_hits;
+
+static bool tri_hits_push(tri *t, void *ctx) {
+  tri_hits *h = ctx;
+  tri8_push(&h->batch, t, h->o, h->hit_t, &h->total);
+  return 0;
+}
+
+// sums the hits of every triangle of sta around o
+static hit hit_sta(body *sta, body *o, tri_fn hit_t) {
+  tri_hits h = {.box = body_get_box(o), .o = o, .hit_t = hit_t};
+  sta_visit(sta, tri_hits_push, &h);
+
+  if (h.batch.n) hit_t(&h.batch, o, &h.total);
+  return hit_total(h.total);
+}
+
+hit hit_mb(body *tmesh_obj, body *ball_obj) {
+  return hit_sta(tmesh_obj, ball_obj, hit_tb);
+}
+
+hit hit_mc(body *tmesh_obj, body *cap_obj) {
+  return hit_sta(tmesh_obj, cap_obj, hit_tc);
 }
 
 hit body_hit(body *a, body *b) {
@@ -268,10 +412,58 @@ hit body_hit(body *a, body *b) {
     case bt_cap | bt_ball: return hit_bc(b, a);
     case bt_mesh | bt_ball: return hit_mb(a, b);
     case bt_mesh | bt_cap: return hit_mc(a, b);
+    // the height field has the highest type, so it always comes in as b
+    case bt_height | bt_ball: return hit_inv(hit_sta(b, a, hit_tb));
+    case bt_height | bt_cap: return hit_inv(hit_sta(b, a, hit_tc));
     case bt_mesh: throwf("body_hit: two meshes may not collide!");
+    case bt_height:
+    case bt_height | bt_mesh:
+      throwf("body_hit: static bodies may not collide!");
   }
 }
 
+typedef struct tri_gather {
+  box3 box;
+  tri **tris;
+} tri_gather;
+
+static bool tri_gather_add(tri *t, void *ctx) {
+  arr_add(((tri_gather *)ctx)->tris, t);
+  return 0;
+}
+
+// gathers sta's triangles around box into c, with some room to move
+static void tri_cache_fill(body *sta, tri_cache *c, box3 box) {
+  c->box = box3_grow(box, tri_cache_margin);
+  if (!c->tris) c->tris = arr_new(tri);
+  arr_clear(c->tris);
+
+  sta_visit(sta, tri_gather_add, &(tri_gather){c->box, &c->tris});
+}
+
+hit body_hit_cached(body *a, body *b, tri_cache *c) {
+  if (!(a->type & (bt_mesh | bt_height))) return body_hit(a, b);
+  if (!body_is_hit_plausible(a, b)) return hit_miss;
+
+  box3 box = body_get_box(b);
+  if (!c->tris || !box3_inside(c->box, box)) tri_cache_fill(a, c, box);
+
+  tri_fn hit_t = b->type == bt_ball ? hit_tb : hit_tc;
+  v3 total = v3_zero;
+  tri8 batch = {};
+  for (tri *t = c->tris, *end = arr_end(c->tris); t != end; t++) {
+    if (box3_overlaps(t->box, box)) tri8_push(&batch, t, b, hit_t, &total);
+  }
+
+  if (batch.n) hit_t(&batch, b, &total);
+  return hit_total(total);
+}
+
+void tri_cache_del(tri_cache *c) {
+  if (c->tris) arr_del(c->tris);
+  c->tris = NULL;
+}
+
 cap cap_new(v3 norm, float rad, float ext) {
   return (cap){
     .type = bt_cap,
@@ -298,7 +490,322 @@ ball ball_new(float rad) {
 
 void body_tick(body *b, float t) {
   b->pos = v3_add(b->pos, b->vel);
-  b->vel.y -= 0.0981f * t * t * 0.33f * 0.33f;
+  b->vel.y -= body_fall(t);
+}
+
+static v3 tri_center(tri *t) {
+  return v3_mul(v3_add(t->box.min, t->box.max), 0.5f);
+}
+
+static float box3_area(box3 b) {
+  v3 e = v3_sub(b.max, b.min);
+  return e.x * e.y + e.y * e.z + e.z * e.x;
+}
+
+static int bvh_bin(tri *t, int axis, float lo, float scale) {
+  return min((int)((tri_center(t).v[axis] - lo) * scale), bvh_bins - 1);
+}
+
+// splits tris [first, first + count) along the longest axis of their centers,
+// at whichever bin boundary gives the smallest surface area cost
+static void bvh_build(bvh_node **nodes, tri *tris, int first, int count,
+                      int depth) {
+  int self = arr_len(*nodes);
+  box3 box = tris[first].box;
+  v3 c_min = tri_center(&tris[first]), c_max = c_min;
+  for (int i = first + 1; i < first + count; i++) {
+    box = box3_fit(box, tris[i].box);
+    c_min = v3_min(c_min, tri_center(&tris[i]));
+    c_max = v3_max(c_max, tri_center(&tris[i]));
+  }
+
+  arr_add(nodes, &(bvh_node){.box = box, .first = first, .count = count});
+
+  v3 ext = v3_sub(c_max, c_min);
+  int axis = ext.x > ext.y ? (ext.x > ext.z ? 0 : 2) : (ext.y > ext.z ? 1 : 2);
+  // centers that all coincide can't be split
+  if (count <= bvh_leaf_size || depth == bvh_max_depth || ext.v[axis] < 1e-6f)
+    return;
+
+  float lo = c_min.v[axis], scale = bvh_bins / ext.v[axis];
+  box3 bin_box[bvh_bins];
+  int bin_n[bvh_bins] = {};
+  for (int i = first; i < first + count; i++) {
+    int b = bvh_bin(&tris[i], axis, lo, scale);
+    bin_box[b] = bin_n[b] ? box3_fit(bin_box[b], tris[i].box) : tris[i].box;
+    bin_n[b]++;
+  }
+
+  // cost of everything left of each boundary, then sweep in from the right
+  float left_cost[bvh_bins];
+  int left_n[bvh_bins];
+  box3 acc;
+  for (int b = 0, n = 0; b < bvh_bins - 1; b++) {
+    if (bin_n[b]) acc = n ? box3_fit(acc, bin_box[b]) : bin_box[b];
+    n += bin_n[b];
+    left_n[b] = n;
+    left_cost[b] = n ? n * box3_area(acc) : 0;
+  }
+
+  // the first and last bins always hold a center, so both sides are nonempty
+  float best = 1e30f;
+  int split = 1;
+  for (int b = bvh_bins - 1, n = 0; b > 0; b--) {
+    if (bin_n[b]) acc = n ? box3_fit(acc, bin_box[b]) : bin_box[b];
+    n += bin_n[b];
+    float cost = left_cost[b - 1] + n * box3_area(acc);
+    if (n && left_n[b - 1] && cost < best) {
+      best = cost;
+      split = b;
+    }
+  }
+
+  int mid = first;
+  for (int i = first; i < first + count; i++) {
+    if (bvh_bin(&tris[i], axis, lo, scale) >= split) continue;
+    tri t = tris[i];
+    tris[i] = tris[mid];
+    tris[mid++] = t;
+  }
+
+  bvh_build(nodes, tris, first, mid - first, depth + 1);
+  (*nodes)[self].first = arr_len(*nodes);
+  (*nodes)[self].count = 0;
+  bvh_build(nodes, tris, mid, first + count - mid, depth + 1);
+}
+
+// reorders m's triangles and builds its tree over them
+static void tmesh_build(tmesh *m) {
+  m->nodes = arr_new(bvh_node);
+  if (!arr_is_empty(m->tris))
+    bvh_build(&m->nodes, m->tris, 0, arr_len(m->tris), 0);
+}
+
+// moller-trumbore, distance along d or -1
+static float tri_raycast(tri *t, v3 o, v3 d) {
+  v3 e1 = v3_sub(t->pos[1], t->pos[0]), e2 = v3_sub(t->pos[2], t->pos[0]);
+  v3 p = v3_cross(d, e2);
+  float det = v3_dot(e1, p);
+  if (fabsf(det) < 1e-8f) return -1;
+
+  float inv = 1.f / det;
+  v3 s = v3_sub(o, t->pos[0]);
+  float u = v3_dot(s, p) * inv;
+  if (u < 0 || u > 1) return -1;
+
+  v3 q = v3_cross(s, e1);
+  float v = v3_dot(d, q) * inv;
+  if (v < 0 || u + v > 1) return -1;
+
+  return v3_dot(e2, q) * inv;
+}
+
+// how far along d o gets before its surface reaches t's face, or 1. only
+// motion into the front of the face counts, edges are left to the narrowphase
+static float tri_toi(tri *t, body *o, v3 d) {
+  if (v3_dot(d, t->norm) >= 0) return 1;
+
+  // the point of o nearest the plane
+  v3 lead = v3_sub(o->pos, v3_mul(t->norm, body_get_rad(o)));
+  if (o->type == bt_cap) {
+    float side = v3_dot(o->cap.norm, t->norm) > 0 ? -1 : 1;
+    lead = v3_add(lead, v3_mul(o->cap.norm, o->cap.ext * side));
+  }
+
+  // behind the plane already, or not reaching it
+  float s = tri_raycast(t, lead, d);
+  if (s < 0 || s >= 1) return 1;
+
+  // a little past the contact, so the narrowphase still sees the hit
+  return min(s + body_get_rad(o) * toi_overshoot / v3_len(d), 1.f);
+}
+
+typedef struct toi_walk {
+  box3 box;
+  body *o;
+  v3 d;
+  float best;
+} toi_walk;
+
+static bool toi_walk_tri(tri *t, void *ctx) {
+  toi_walk *w = ctx;
+  w->best = min(w->best, tri_toi(t, w->o, w->d));
+  return 0;
+}
+
+float body_toi(body *sta, body *o, v3 d) {
+  box3 start = body_get_box(o);
+  toi_walk w = {
+    .box = box3_fit(start, box3_new(v3_add(start.min, d), v3_add(start.max, d))),
+    .o = o,
+    .d = d,
+    .best = 1,
+  };
+  sta_visit(sta, toi_walk_tri, &w);
+  return w.best;
+}
+
+// keeps the ray hit at t with normal norm if it beats best
+static void ray_keep(ray_hit *best, float t, v3 norm) {
+  if (t < 0 || t > best->t) return;
+  *best = (ray_hit){.is_hit = 1, .t = t, .norm = norm};
+}
+
+// a ray starting inside the ball hits it at 0
+static void ray_ball(v3 o, v3 d, v3 c, float r, ray_hit *best) {
+  v3 oc = v3_sub(o, c);
+  float b = v3_dot(oc, d), cc = v3_dot(oc, oc) - r * r;
+  if (cc > 0 && b > 0) return;
+
+  float disc = b * b - cc;
+  if (disc < 0) return;
+
+  float t = max(-b - sqrtf(disc), 0.f);
+  v3 out = v3_sub(v3_add(o, v3_mul(d, t)), c);
+  float len = v3_len(out);
+  ray_keep(best, t, len > 0.00001f ? v3_div(out, len) : v3_neg(d));
+}
+
+// the round-ended cylinder of radius r around segment a b
+static void ray_cap(v3 o, v3 d, v3 a, v3 b, float r, ray_hit *best) {
+  v3 ab = v3_sub(b, a), ao = v3_sub(o, a);
+  float ab_sq = v3_dot(ab, ab), ab_d = v3_dot(ab, d), ab_ao = v3_dot(ab, ao);
+
+  // the side of the cylinder, with everything along ab projected out
+  float qa = ab_sq - ab_d * ab_d,
+    qb = ab_sq * v3_dot(ao, d) - ab_ao * ab_d,
+    qc = ab_sq * v3_dot(ao, ao) - ab_ao * ab_ao - r * r * ab_sq;
+  float s0 = ab_ao / ab_sq;
+  if (qc <= 0 && s0 > 0 && s0 < 1) {
+    ray_keep(best, 0, v3_neg(d));
+    return;
+  }
+
+  if (qa > 0.00001f) {
+    float disc = qb * qb - qa * qc;
+    if (disc >= 0) {
+      float t = (-qb - sqrtf(disc)) / qa, s = (ab_ao + t * ab_d) / ab_sq;
+      if (t >= 0 && s > 0 && s < 1) {
+        v3 p = v3_add(o, v3_mul(d, t));
+        ray_keep(best, t, v3_normed(v3_sub(p, v3_add(a, v3_mul(ab, s)))));
+        return;
+      }
+    }
+  }
+
+  ray_ball(o, d, a, r, best);
+  ray_ball(o, d, b, r, best);
+}
+
+// t grown by r, the face moved out toward o and the edges rounded
+static void ray_tri(tri *t, v3 o, v3 d, float r, ray_hit *best) {
+  float side = v3_dot(v3_sub(o, t->pos[0]), t->norm) < 0 ? -1 : 1;
+  v3 norm = v3_mul(t->norm, side), off = v3_mul(norm, r);
+  tri face = *t;
+  for (int i = 0; i < 3; i++) face.pos[i] = v3_add(t->pos[i], off);
+  ray_keep(best, tri_raycast(&face, o, d), norm);
+
+  if (r <= 0) return;
+  for (int i = 0; i < 3; i++) {
+    ray_cap(o, d, t->pos[i], t->pos[(i + 1) % 3], r, best);
+  }
+}
+
+// steps through the cells under the ray, so a long one only tests what it
+// passes over. stops after the first cell with a hit, since later ones
+// can't be closer
+static void ray_height(hfield *f, v3 o, v3 d, float l, float r,
+                       ray_hit *best) {
+  v3 inv_d = {1.f / d.x, 1.f / d.y, 1.f / d.z};
+  box3 box = box3_grow(f->box, r);
+  if (!box3_ray(box, o, inv_d, l)) return;
+
+  // start where the ray enters the field
+  float near = 0;
+  for (int i = 0; i < 3; i++) {
+    float t0 = (box.min.v[i] - o.v[i]) * inv_d.v[i],
+      t1 = (box.max.v[i] - o.v[i]) * inv_d.v[i];
+    near = fmaxf(near, fminf(t0, t1));
+  }
+
+  // cells within r of the ray's cell can be touched too
+  int reach = (int)ceilf(r / f->cell);
+  dda walk = dda_new(o, d, near, (v2){f->origin.x, f->origin.z}, f->cell);
+  while (walk.t <= min(l, best->t)) {
+    for (int i = walk.cell.x - reach; i <= walk.cell.x + reach; i++) {
+      for (int j = walk.cell.y - reach; j <= walk.cell.y + reach; j++) {
+        if (i < 0 || j < 0 || i >= f->n || j >= f->n) continue;
+
+        tri t[2];
+        hfield_cell(f, i, j, t);
+        ray_tri(&t[0], o, d, r, best);
+        ray_tri(&t[1], o, d, r, best);
+      }
+    }
+
+    if (best->is_hit && best->t <= dda_exit(&walk)) return;
+    dda_next(&walk);
+
+    // left the field
+    bool past_x = walk.cell.x < -reach || walk.cell.x >= f->n + reach,
+      past_z = walk.cell.y < -reach || walk.cell.y >= f->n + reach;
+    if (past_x || past_z) return;
+  }
+}
+
+typedef struct ray_walk {
+  v3 o, d, inv_d;
+  float r;
+  ray_hit *best;
+} ray_walk;
+
+// later boxes only need to beat the best so far
+static bool ray_walk_in(box3 b, void *ctx) {
+  ray_walk *w = ctx;
+  return box3_ray(box3_grow(b, w->r), w->o, w->inv_d, w->best->t);
+}
+
+static bool ray_walk_tri(tri *t, void *ctx) {
+  ray_walk *w = ctx;
+  ray_tri(t, w->o, w->d, w->r, w->best);
+  return 0;
+}
+
+static void ray_mesh(tmesh *m, v3 o, v3 d, float r, ray_hit *best) {
+  ray_walk w = {o, d, {1.f / d.x, 1.f / d.y, 1.f / d.z}, r, best};
+  bvh_visit(m, ray_walk_in, ray_walk_tri, &w);
+}
+
+ray_hit body_sweep(body *b, v3 o, v3 d, float l, float r) {
+  ray_hit best = {.t = l};
+
+  switch (b->type) {
+    case bt_ball:
+      ray_ball(o, d, b->pos, b->ball.rad + r, &best);
+      break;
+    case bt_cap: {
+      v3 ext = v3_mul(b->cap.norm, b->cap.ext);
+      ray_cap(o, d, v3_add(b->pos, ext), v3_sub(b->pos, ext), b->cap.rad + r,
+              &best);
+      break;
+    }
+    case bt_mesh: ray_mesh(&b->mesh, o, d, r, &best); break;
+    case bt_height: ray_height(&b->height, o, d, l, r, &best); break;
+  }
+
+  return best;
+}
+
+static bool tri_found(tri *t, void *ctx) {
+  return 1;
+}
+
+bool body_overlaps_box(body *b, box3 box) {
+  if (!box3_overlaps(body_get_box(b), box)) return 0;
+  if (b->type == bt_mesh || b->type == bt_height)
+    return sta_visit(b, tri_found, &box);
+
+  return 1;
 }
 
 tmesh tmesh_new(tri *tris) {
@@ -322,16 +829,28 @@ tmesh tmesh_new(tri *tris) {
 
   arr_del(tris);
 
-  return (tmesh){
+  tmesh m = {
     .type = bt_mesh,
     .tris = objs,
     .box = (box3){.min = min, .max = max}
   };
+  tmesh_build(&m);
+
+  return m;
+}
+
+float body_get_rad(body *b) {
+  switch (b->type) {
+    case bt_ball: return b->ball.rad;
+    case bt_cap: return b->cap.rad;
+    default: return 0;
+  }
 }
 
 box3 body_get_box(body *b) {
   switch (b->type) {
     case bt_mesh: return b->mesh.box;
+    case bt_height: return b->height.box;
     case bt_ball: {
       ball ball = b->ball;
       return (box3){.min = v3_add(b->pos,
@@ -369,7 +888,10 @@ tmesh tmesh_new_vi(obj_vtx *verts, int *inds) {
     max = v3_max(v3_max(v3_max(max, a), b), c);
   }
 
-  return (tmesh){.tris = mesh, .box = box3_new(min, max), .type = bt_mesh};
+  tmesh m = {.tris = mesh, .box = box3_new(min, max), .type = bt_mesh};
+  tmesh_build(&m);
+
+  return m;
 }
 
 tmesh tmesh_new_cvi(ch_vtx *verts, int *inds) {
@@ -388,7 +910,10 @@ tmesh tmesh_new_cvi(ch_vtx *verts, int *inds) {
     max = v3_max(v3_max(v3_max(max, a), b), c);
   }
 
-  return (tmesh){.tris = mesh, .box = box3_new(min, max), .type = bt_mesh};
+  tmesh m = {.tris = mesh, .box = box3_new(min, max), .type = bt_mesh};
+  tmesh_build(&m);
+
+  return m;
 }
 
 v3 body_get_ipos(body *o, float d) {
@@ -411,13 +936,34 @@ tmesh tmesh_add(tmesh *orig, v3 pos) {
   };
 
   arr_copy(&m.tris, orig->tris);
+  m.nodes = arr_new(bvh_node);
+  arr_copy(&m.nodes, orig->nodes);
 
   for (tri *t = m.tris, *end = arr_end(m.tris); t != end; t++) {
     v3_inc(&t->pos[0], pos);
     v3_inc(&t->pos[1], pos);
     v3_inc(&t->pos[2], pos);
+    t->box = box3_add(t->box, pos);
   }
 
+  for (bvh_node *n = m.nodes, *end = arr_end(m.nodes); n != end; n++)
+    n->box = box3_add(n->box, pos);
+
   return m;
 }
 
+int *quad_indices(int w, int h) {
+  int *inds = arr_new_sized(int, (w - 1) * (h - 1) * 6);
+
+  for (int i = 0; i < h - 1; i++)
+    for (int j = 0; j < w - 1; j++) {
+      arr_add(&inds, &(int){(i + 1) * w + j + 1});
+      arr_add(&inds, &(int){(i + 1) * w + j});
+      arr_add(&inds, &(int){i * w + j});
+      arr_add(&inds, &(int){i * w + j});
+      arr_add(&inds, &(int){i * w + j + 1});
+      arr_add(&inds, &(int){(i + 1) * w + j + 1});
+    }
+
+  return inds;
+}
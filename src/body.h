@@ -8,7 +8,8 @@
 typedef enum body_type {
   bt_mesh = 1 << 0,
   bt_cap = 1 << 1,
-  bt_ball = 1 << 2
+  bt_ball = 1 << 2,
+  bt_height = 1 << 3
 } body_type;
 
 typedef struct tri {
@@ -34,19 +35,52 @@ typedef struct ball {
 
 ball ball_new(float rad);
 
+// a node of a tmesh's aabb tree. inner nodes keep their left child right
+// after them and the right one at first; leaves cover tris [first, first + count).
+typedef struct bvh_node {
+  box3 box;
+  int first, count;
+} bvh_node;
+
 typedef struct tmesh {
   body_type type;
+  // ordered so every leaf's triangles are contiguous
   tri *tris;
+  // the tree flattened depth first as an arr, root first
+  bvh_node *nodes;
   box3 box;
 } tmesh;
 
-struct obj_vtx; struct ch_vtx;
+// a grid of heights, split into triangles the same way as quad_indices.
+// vertex (i, j) sits at origin + (i * cell, h[i * (n + 1) + j], j * cell).
+typedef struct hfield {
+  body_type type;
+  v3 origin;
+  float cell;
+  int n;
+  // (n + 1)^2 heights, as an arr
+  float *h;
+  box3 box;
+} hfield;
+
+// takes ownership of h.
+hfield hfield_new(v3 origin, float cell, int n, float *h);
+
+struct ch_vtx;
+
+typedef struct obj_vtx {
+  v3 pos;
+  v3 norm;
+} obj_vtx;
 
 tmesh tmesh_new(tri *tris);
 tmesh tmesh_new_vi(struct obj_vtx *verts, int *inds);
 tmesh tmesh_new_cvi(struct ch_vtx *verts, int *inds);
 tmesh tmesh_add(tmesh *orig, v3 pos);
 
+// two triangles per cell of a w * h vertex grid, as an arr.
+int *quad_indices(int w, int h);
+
 typedef struct body {
   union {
     body_type type;
@@ -54,6 +88,7 @@ typedef struct body {
     cap cap;
     ball ball;
     tmesh mesh;
+    hfield height;
   };
 
   float slip;
@@ -83,10 +118,50 @@ v3 body_get_ipos(body *o, float d);
 
 hit body_hit(body *a, body *b);
 
+// the triangles of a static body around a dynamic one, kept so they aren't
+// searched for again while it stays inside box.
+typedef struct tri_cache {
+  box3 box;
+  // an arr, NULL until first filled
+  tri *tris;
+} tri_cache;
+
+// body_hit for a static a and dynamic b, only searching a's triangles again
+// once b has left c.
+hit body_hit_cached(body *a, body *b, tri_cache *c);
+
+void tri_cache_del(tri_cache *c);
+
+// how much gravity takes off vel.y in a step of length t.
+inline static float body_fall(float t) {
+  return 0.0981f * t * t * 0.33f * 0.33f;
+}
+
 void body_tick(body *o, float t);
 
 box3 body_get_box(body *o);
 
+typedef struct ray_hit {
+  bool is_hit;
+  // distance along the ray, and the surface's normal there
+  float t;
+  v3 norm;
+} ray_hit;
+
+// sweeps a ball of radius r from o along the unit dir d for up to l, a ray if
+// r is 0. starting inside a ball or capsule hits it at 0.
+ray_hit body_sweep(body *b, v3 o, v3 d, float l, float r);
+
+// whether b might overlap box, down to the triangles of static bodies.
+bool body_overlaps_box(body *b, box3 box);
+
+// the radius of a ball or capsule, 0 for static bodies.
+float body_get_rad(body *o);
+
+// the fraction of the motion d dynamic o can make before hitting the terrain
+// in sta, or 1.
+float body_toi(body *sta, body *o, v3 d);
+
 [[gnu::always_inline]]
 inline static bool body_is_hit_plausible(body *a, body *b) {
   return box3_overlaps(body_get_box(a), body_get_box(b));
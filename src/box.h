@@ -55,6 +55,33 @@ inline static bool box3_overlaps(box3 a, box3 b) {
 #undef overlaps
 }
 
+[[gnu::always_inline]]
+inline static bool box3_inside(box3 outer, box3 inner) {
+  return inner.min.x >= outer.min.x && inner.min.y >= outer.min.y &&
+         inner.min.z >= outer.min.z && inner.max.x <= outer.max.x &&
+         inner.max.y <= outer.max.y && inner.max.z <= outer.max.z;
+}
+
+// slab test against the segment [o, o + d * l]
+[[gnu::always_inline]]
+inline static bool box3_ray(box3 b, v3 o, v3 inv_d, float l) {
+  float near = 0, far = l;
+  for (int i = 0; i < 3; i++) {
+    float t0 = (b.min.v[i] - o.v[i]) * inv_d.v[i],
+      t1 = (b.max.v[i] - o.v[i]) * inv_d.v[i];
+    near = fmaxf(near, fminf(t0, t1));
+    far = fminf(far, fmaxf(t0, t1));
+  }
+
+  return near <= far;
+}
+
+[[gnu::always_inline]]
+inline static box3 box3_grow(box3 b, float by) {
+  return box3_new(v3_sub(b.min, (v3){by, by, by}),
+                  v3_add(b.max, (v3){by, by, by}));
+}
+
 typedef struct box2 {
   v2 min, max;
 } box2;
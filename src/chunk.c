@@ -1,23 +1,93 @@
 #include "chunk.h"
 #include "world.h"
 #include "lib/simplex/FastNoiseLite.h"
-#include "app.h"
-#include "pal.h"
+#include <pthread.h>
+
+// chunks are generated on several threads at once, so the shared state is
+// set up exactly once instead of lazily on first use.
+static pthread_once_t chunk_once = PTHREAD_ONCE_INIT;
+static fnl_state noise;
+
+static void chunk_init() {
+  noise = fnlCreateState();
+  noise.noise_type = FNL_NOISE_OPENSIMPLEX2S;
+  noise.seed = chunk_seed;
+}
+
+// the terrain is a sum of noise octaves: y += noise(p * scale + off) * amp
+static struct octave {
+  float scale, off_x, off_z, amp;
+} const octaves[] = {
+  {9.f,   chunk_sizef * -63.f, chunk_sizef * 48.f, 0.5f},
+  {2.f,   chunk_sizef * 15.f,  chunk_sizef * 15.f, 4.5f},
+  {1.f,   0.f,                 0.f,                9.5f},
+  {0.25f, -112.f,              32.f,               18.5f},
+};
+
+#define n_octaves (sizeof(octaves) / sizeof(octaves[0]))
+#define y_block 128
 
 float chunk_get_y(v3 world_pos) {
-  static fnl_state *noise = NULL;
-  if (!noise) {
-    noise = _new_(fnlCreateState());
-    noise->noise_type = FNL_NOISE_OPENSIMPLEX2S;
+  pthread_once(&chunk_once, chunk_init);
+
+  float f = 0;
+  for (int i = 0; i < n_octaves; i++) {
+    struct octave o = octaves[i];
+    f += fnlGetNoise2D(&noise, world_pos.x * o.scale + o.off_x,
+                       world_pos.z * o.scale + o.off_z) * o.amp;
   }
 
-  float f = fnlGetNoise2D(noise, world_pos.x * 9 + chunk_sizef * -63.f, world_pos.z * 9 + chunk_sizef * 48.f) * 0.5f +
-         fnlGetNoise2D(noise, world_pos.x * 2.f + chunk_sizef * 15.f, world_pos.z * 2.f + chunk_sizef * 15.f) * 4.5f +
-         fnlGetNoise2D(noise, world_pos.x, world_pos.z) * 9.5f +
-         fnlGetNoise2D(noise, world_pos.x * 0.25f - 112, world_pos.z * 0.25f + 32) * 18.5f;
   return f;
 }
 
+void chunk_get_y_n(float const *x, float const *z, float *y, float *dydx,
+                   float *dydz, int n) {
+  pthread_once(&chunk_once, chunk_init);
+
+  bool grad = dydx && dydz;
+  float ox[y_block], oz[y_block], val[y_block], dx[y_block], dz[y_block];
+
+  for (int start = 0; start < n; start += y_block) {
+    int len = min(y_block, n - start);
+    for (int k = 0; k < len; k++) {
+      y[start + k] = 0;
+      if (grad) dydx[start + k] = dydz[start + k] = 0;
+    }
+
+    for (int i = 0; i < n_octaves; i++) {
+      struct octave o = octaves[i];
+      for (int k = 0; k < len; k++) {
+        ox[k] = x[start + k] * o.scale + o.off_x;
+        oz[k] = z[start + k] * o.scale + o.off_z;
+      }
+
+      if (!grad) {
+        fnlGetNoise2DN(&noise, ox, oz, val, len);
+      } else {
+        fnlGetNoise2DGradN(&noise, ox, oz, val, dx, dz, len);
+      }
+
+      for (int k = 0; k < len; k++) {
+        y[start + k] += val[k] * o.amp;
+      }
+
+      if (!grad) continue;
+
+      // chain rule through the octave's input scale
+      for (int k = 0; k < len; k++) {
+        dydx[start + k] += dx[k] * o.scale * o.amp;
+        dydz[start + k] += dz[k] * o.scale * o.amp;
+      }
+    }
+  }
+}
+
+v3 chunk_get_norm(v3 world_pos) {
+  float y, dx, dz;
+  chunk_get_y_n(&world_pos.x, &world_pos.z, &y, &dx, &dz, 1);
+  return v3_normed((v3){-dx, 1.f, -dz});
+}
+
 v3 chunk_get_pos(iv2 pos, int off_x, int off_z) {
   v3 base = {
     (float)pos.x * chunk_sizef + (float)off_x * chunk_ratio,
@@ -41,96 +111,90 @@ v3 chunk_get_posf(iv2 pos, float off_x, float off_z) {
 }
 
 v3 norm_at(iv2 pos, float i, float j) {
-  v3 a = chunk_get_posf(pos, i, j), b = chunk_get_posf(pos, i + 0.01f, j), c = chunk_get_posf(pos, i, j + 0.01f);
-  return v3_normed(v3_cross(v3_sub(c, a), v3_sub(b, a)));
+  return chunk_get_norm((v3){
+    (float)pos.x * chunk_sizef + i * chunk_ratio,
+    0,
+    (float)pos.y * chunk_sizef + j * chunk_ratio
+  });
 }
 
+// fills in pos and norm for the whole grid. the normals come from the
+// analytic derivative that falls out of the same noise evaluation as the
+// heights.
 void chunk_build_normals(iv2 pos, ch_vtx *verts) {
-  static iv2 norm_offsets[] = {
-    (iv2){1, 0}, (iv2){1, 1}, (iv2){0, 1}
-  };
+#define n_verts (chunk_len * chunk_len)
+  float x[n_verts], z[n_verts], y[n_verts], dx[n_verts], dz[n_verts];
 
   for (int i = 0; i < chunk_len; i++) {
     for (int j = 0; j < chunk_len; j++) {
-      verts[i * chunk_len + j].norm = norm_at(pos, i, j);
+      x[i * chunk_len + j] = (float)pos.x * chunk_sizef + (float)i * chunk_ratio;
+      z[i * chunk_len + j] = (float)pos.y * chunk_sizef + (float)j * chunk_ratio;
     }
   }
-}
 
-chunk chunk_new(world *w, iv2 pos) {
-  static int *inds = NULL;
-  if (!inds) {
-    inds = quad_indices(chunk_len, chunk_len);
+  chunk_get_y_n(x, z, y, dx, dz, n_verts);
+
+  for (int i = 0; i < n_verts; i++) {
+    verts[i].pos = (v3){x[i], y[i], z[i]};
+    verts[i].norm = v3_normed((v3){-dx[i], 1.f, -dz[i]});
   }
+#undef n_verts
+}
 
-  int id = rndi(INT_MIN, INT_MAX);
+void chunk_build_body(chunk *c) {
+  pthread_once(&chunk_once, chunk_init);
 
-  ch_vtx verts[chunk_len * chunk_len];
-  for (int i = 0; i < chunk_len; i++) {
-    for (int j = 0; j < chunk_len; j++) {
-      verts[i * chunk_len + j].pos = chunk_get_pos(pos, i, j);
-      verts[i * chunk_len + j].norm = v3_zero;
-      verts[i * chunk_len + j].id = id;
-    }
+  float *h = arr_new_sized(float, chunk_len * chunk_len);
+  for (int i = 0; i < chunk_len * chunk_len; i++) {
+    arr_add(&h, &c->data[i].pos.y);
   }
 
-  chunk_build_normals(pos, verts);
+  v3 origin = {(float)c->pos.x * chunk_sizef, 0, (float)c->pos.y * chunk_sizef};
+  c->body = (body){
+    .height = hfield_new(origin, chunk_ratio, chunk_qty, h),
+    .slip = 0.99f,
+  };
+}
 
-  body phys = (body){.mesh = tmesh_new_cvi(verts, inds), .slip = 0.99f};
+chunk chunk_new(iv2 pos) {
+  crng ids = crng_new(chunk_seed, pos, cs_id),
+    trees = crng_new(chunk_seed, pos, cs_tree);
+  int id = (int)crng_u32(&ids);
 
   chunk c = {
-    .body = phys,
+    .id = id,
+    .pos = pos,
   };
 
-  memcpy(c.data, verts, chunk_len * chunk_len * sizeof(ch_vtx));
+  for (int i = 0; i < chunk_len * chunk_len; i++) {
+    c.data[i].id = id;
+  }
+
+  chunk_build_normals(pos, c.data);
+  chunk_build_body(&c);
 
-  if (rndf(0, 1) > 0.4) {
-    float xo = rndf(0, chunk_size), zo = rndf(0, chunk_size);
-    obj t = tree_new(chunk_get_posf(pos, xo, zo), norm_at(pos, xo, zo));
-    world_add_obj(w, &t);
+  if (crng_f(&trees, 0, 1) > 0.4) {
+    float xo = crng_f(&trees, 0, chunk_size), zo = crng_f(&trees, 0, chunk_size);
+    c.has_tree = 1;
+    c.tree_pos = chunk_get_posf(pos, xo, zo);
+    c.tree_dir = norm_at(pos, xo, zo);
   }
 
   return c;
 }
 
-shdr *ch_get_sh(draw_src s, cam *c) {
-  static shdr *cam = NULL;
-  static shdr *shade = NULL;
-  static mtl m = {
-    .light = 6,
-    .dark = 0,
-    .light_model = {0, 0.8f, 0},
-    .alpha = 1.f
-  };
+void chunk_spawn(chunk *c, world *w) {
+  c->tree_id = -1;
+  if (!c->has_tree) return;
 
-  if (!cam) {
-    cam = _new_(shdr_new(2,
-                         (shdr_s[]){
-                           {GL_VERTEX_SHADER,   "res/chunk.vsh"},
-                           {GL_FRAGMENT_SHADER, "res/mod_light.fsh"},
-                         }));
-
-    shade = _new_(shdr_new(2,
-                           (shdr_s[]){
-                             {GL_VERTEX_SHADER,   "res/mod_depth.vsh"},
-                             {GL_FRAGMENT_SHADER, "res/mod_depth.fsh"},
-                           }));
-  }
+  // the world's obj lists belong to the tick thread
+  crng r = crng_new(chunk_seed, c->pos, cs_tree_obj);
+  obj t = tree_new(c->tree_pos, c->tree_dir, &r);
+  world_add_obj(w, &t);
+  c->tree_id = t.id;
+}
 
-  shdr *cur = s == ds_cam ? cam : shade;
-
-  shdr_m4f(cur, "u_vp", c->vp);
-  shdr_m4f(cur, "u_model", m4_ident);
-  shdr_3f(cur, "u_eye", cam_get_eye(c));
-  shdr_1f(cur, "u_time", app_now() / 1000.f);
-  shdr_3f(cur, "u_light_model", m.light_model);
-  shdr_3f(cur, "u_light", dreamy_haze[m.light]);
-  shdr_3f(cur, "u_dark", dreamy_haze[m.dark]);
-  shdr_1f(cur, "u_trans", m.transmission);
-  shdr_1f(cur, "u_shine", m.shine);
-  shdr_1f(cur, "u_wind", m.wind);
-  shdr_1f(cur, "u_alpha", m.alpha);
-  shdr_bind(cur);
-
-  return cur;
+void chunk_del(chunk *c) {
+  arr_del(c->body.height.h);
+  c->body.height.h = NULL;
 }
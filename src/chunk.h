@@ -1,6 +1,5 @@
 #pragma once
 
-#include "gl.h"
 #include "body.h"
 
 #define chunk_size 8
@@ -8,6 +7,15 @@
 #define chunk_qty 8
 #define chunk_len (chunk_qty + 1)
 static const float chunk_ratio = (float)chunk_size / (float)chunk_qty;
+// seeds the terrain noise and every crng used to generate a chunk
+#define chunk_seed 1337u
+
+// crng streams, so each use of a chunk's randomness is independent
+typedef enum chunk_stream {
+  cs_id,
+  cs_tree,
+  cs_tree_obj,
+} chunk_stream;
 
 typedef struct ch_vtx {
   v3 pos;
@@ -19,13 +27,39 @@ typedef struct chunk {
   body body;
   ch_vtx data[chunk_len * chunk_len];
   int id;
+  iv2 pos;
+
+  // trees are spawned by the tick thread once the chunk is added
+  bool has_tree;
+  v3 tree_pos, tree_dir;
+  // id of the spawned tree, -1 if there is none
+  int tree_id;
+  // grid handle of body, set by world_add_chunk
+  int proxy;
+  // world_stream pass that last had this chunk in range, for eviction
+  unsigned last_seen;
 } chunk;
 
 float chunk_get_y(v3 world_pos);
 
+// chunk_get_y for n points at once, y[i] = chunk_get_y({x[i], 0, z[i]}).
+// dydx and dydz receive the slope of the terrain unless they are null.
+void chunk_get_y_n(float const *x, float const *z, float *y, float *dydx,
+                   float *dydz, int n);
+
+v3 chunk_get_norm(v3 world_pos);
+
 v3 chunk_get_pos(iv2 pos, int off_x, int off_z);
 
+// safe to call from any thread.
+chunk chunk_new(iv2 pos);
+
+// builds the collider from data, for chunks that were loaded rather than
+// generated.
+void chunk_build_body(chunk *c);
+
 struct world;
-chunk chunk_new(struct world *w, iv2 pos);
+void chunk_spawn(chunk *c, struct world *w);
 
-shdr *ch_get_sh(draw_src s, cam *c);
\ No newline at end of file
+// frees the collider. the spawned tree is the world's to remove.
+void chunk_del(chunk *c);
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "typedefs.h"
+
+/*-- walks the square cells a ray crosses in xz, nearest first. --*/
+
+typedef struct dda {
+  iv2 cell, step;
+  // the ray's t where it enters the current cell, and where it next crosses
+  // an x or a z boundary
+  float t, next_x, next_z;
+  // t between boundaries on each axis
+  float dt_x, dt_z;
+} dda;
+
+// starts at t along o + d * t, for cells of size cell with a corner at origin.
+[[gnu::always_inline]]
+inline static dda dda_new(v3 o, v3 d, float t, v2 origin, float cell) {
+  v3 p = v3_add(o, v3_mul(d, t));
+  float fx = (p.x - origin.x) / cell, fz = (p.z - origin.y) / cell;
+  dda r = {
+    .cell = {(int)floorf(fx), (int)floorf(fz)},
+    .step = {d.x < 0 ? -1 : 1, d.z < 0 ? -1 : 1},
+    .t = t,
+    .dt_x = d.x == 0 ? INFINITY : cell / fabsf(d.x),
+    .dt_z = d.z == 0 ? INFINITY : cell / fabsf(d.z),
+  };
+
+  float to_x = d.x < 0 ? fx - (float)r.cell.x : (float)r.cell.x + 1 - fx,
+    to_z = d.z < 0 ? fz - (float)r.cell.y : (float)r.cell.y + 1 - fz;
+  r.next_x = t + to_x * r.dt_x;
+  r.next_z = t + to_z * r.dt_z;
+  return r;
+}
+
+// the t where the ray leaves the current cell.
+[[gnu::always_inline]]
+inline static float dda_exit(dda *r) {
+  return fminf(r->next_x, r->next_z);
+}
+
+[[gnu::always_inline]]
+inline static void dda_next(dda *r) {
+  if (r->next_x < r->next_z) {
+    r->t = r->next_x;
+    r->next_x += r->dt_x;
+    r->cell.x += r->step.x;
+  } else {
+    r->t = r->next_z;
+    r->next_z += r->dt_z;
+    r->cell.y += r->step.y;
+  }
+}
@@ -0,0 +1,134 @@
+#include "gen.h"
+#include "arr.h"
+#include <limits.h>
+
+static int gen_pick(gen *g) {
+  int best = -1;
+  int best_dist = INT_MAX;
+  for (int i = 0, len = arr_len(g->todo); i < len; i++) {
+    iv2 d = iv2_sub(g->todo[i], g->center);
+    int dist = iv2_dot(d, d);
+    if (dist < best_dist) {
+      best_dist = dist;
+      best = i;
+    }
+  }
+
+  return best;
+}
+
+static void *gen_worker(void *gp) {
+  gen *g = gp;
+
+  pthread_mutex_lock(&g->lock);
+  while (true) {
+    while (arr_is_empty(g->todo)) {
+      pthread_cond_wait(&g->has_todo, &g->lock);
+    }
+
+    // closest to the camera first
+    int idx = gen_pick(g);
+    iv2 pos = g->todo[idx];
+    g->todo[idx] = *(iv2 *)arr_last(g->todo);
+    arr_len(g->todo)--;
+    g->n_busy++;
+    pthread_mutex_unlock(&g->lock);
+
+    chunk c;
+    if (!rfile_store_load(g->store, pos, &c)) {
+      c = chunk_new(pos);
+      rfile_store_save(g->store, &c);
+    }
+
+    pthread_mutex_lock(&g->lock);
+    arr_add(&g->done, &c);
+    g->n_busy--;
+    pthread_cond_broadcast(&g->has_done);
+  }
+
+  return NULL;
+}
+
+gen *gen_new(rfile_store *store) {
+  gen *g = _new_((gen){
+    .store = store,
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .has_todo = PTHREAD_COND_INITIALIZER,
+    .has_done = PTHREAD_COND_INITIALIZER,
+    .todo = arr_new(iv2),
+    .done = arr_new(chunk),
+    .pending = map_new(16, sizeof(iv2), sizeof(bool), 0.5f, iv2_peq, iv2_hash),
+  });
+
+  for (int i = 0; i < gen_n_workers; i++) {
+    pthread_create(&g->workers[i], NULL, gen_worker, g);
+  }
+
+  return g;
+}
+
+void gen_request(gen *g, iv2 pos) {
+  bool *queued = map_at(&g->pending, &pos);
+  if (queued && *queued) return;
+
+  if (queued) *queued = 1;
+  else map_add(&g->pending, &pos, &(bool){1});
+
+  pthread_mutex_lock(&g->lock);
+  arr_add(&g->todo, &pos);
+  pthread_cond_signal(&g->has_todo);
+  pthread_mutex_unlock(&g->lock);
+}
+
+void gen_recenter(gen *g, iv2 center, int range) {
+  pthread_mutex_lock(&g->lock);
+  g->center = center;
+
+  for (int i = 0; i < arr_len(g->todo);) {
+    iv2 d = iv2_sub(g->todo[i], center);
+    if (abs(d.x) <= range && abs(d.y) <= range) {
+      i++;
+      continue;
+    }
+
+    *(bool *)map_at(&g->pending, &g->todo[i]) = 0;
+    g->todo[i] = *(iv2 *)arr_last(g->todo);
+    arr_len(g->todo)--;
+  }
+
+  pthread_mutex_unlock(&g->lock);
+}
+
+void gen_forget(gen *g, iv2 pos) {
+  bool *queued = map_at(&g->pending, &pos);
+  if (queued && !*queued) map_remove(&g->pending, &pos);
+}
+
+static void gen_pop(gen *g, chunk *out) {
+  *out = *(chunk *)arr_last(g->done);
+  arr_len(g->done)--;
+  *(bool *)map_at(&g->pending, &out->pos) = 0;
+}
+
+bool gen_poll(gen *g, chunk *out) {
+  pthread_mutex_lock(&g->lock);
+  bool any = !arr_is_empty(g->done);
+  if (any) gen_pop(g, out);
+  pthread_mutex_unlock(&g->lock);
+
+  return any;
+}
+
+bool gen_wait(gen *g, chunk *out) {
+  pthread_mutex_lock(&g->lock);
+  while (arr_is_empty(g->done) &&
+         (!arr_is_empty(g->todo) || g->n_busy)) {
+    pthread_cond_wait(&g->has_done, &g->lock);
+  }
+
+  bool any = !arr_is_empty(g->done);
+  if (any) gen_pop(g, out);
+  pthread_mutex_unlock(&g->lock);
+
+  return any;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <pthread.h>
+#include "typedefs.h"
+#include "map.h"
+#include "chunk.h"
+#include "rfile.h"
+
+/*-- a pool of threads that generates chunks off the tick thread. --*/
+
+#define gen_n_workers 4
+
+typedef struct gen {
+  pthread_t workers[gen_n_workers];
+  pthread_mutex_t lock;
+  pthread_cond_t has_todo, has_done;
+
+  // chunks are loaded from here before they are generated
+  rfile_store *store;
+
+  // guarded by lock
+  iv2 *todo;
+  chunk *done;
+  iv2 center;
+  int n_busy;
+
+  // iv2 -> bool, only touched by the tick thread
+  map pending;
+} gen;
+
+gen *gen_new(rfile_store *store);
+
+// queues pos for generation unless it is already queued or in flight.
+void gen_request(gen *g, iv2 pos);
+
+// reorders the queue around center and drops jobs that fell out of range.
+void gen_recenter(gen *g, iv2 center, int range);
+
+// drops the bookkeeping for a chunk that left the world.
+void gen_forget(gen *g, iv2 pos);
+
+// pops a finished chunk into out without blocking.
+bool gen_poll(gen *g, chunk *out);
+
+// blocks until a finished chunk is available. returns 0 once nothing is
+// queued or in flight.
+bool gen_wait(gen *g, chunk *out);
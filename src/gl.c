@@ -212,6 +212,48 @@ void *buf_rw(buf *b, size_t size) {
   return gl_map_named_buffer(b->id, GL_READ_WRITE);
 }
 
+ubo_ring ubo_ring_new(size_t size) {
+  int align;
+  gl_get_integerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &align);
+
+  ubo_ring r = {
+    .buf = buf_new(GL_UNIFORM_BUFFER),
+    .size = size,
+    .stride = (size + align - 1) / align * align,
+  };
+
+  u32 flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+  gl_named_buffer_storage(r.buf.id, r.stride * ubo_ring_n, NULL, flags);
+  r.map = gl_map_named_buffer_range(r.buf.id, 0, r.stride * ubo_ring_n, flags);
+  if (!r.map) throwf("ubo_ring_new: failed to map %zu bytes", size);
+
+  return r;
+}
+
+void *ubo_ring_next(ubo_ring *r) {
+  r->slot = (r->slot + 1) % ubo_ring_n;
+
+  GLsync *f = &r->fences[r->slot];
+  if (*f) {
+    while (gl_client_wait_sync(*f, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) ==
+           GL_TIMEOUT_EXPIRED);
+    gl_delete_sync(*f);
+    *f = NULL;
+  }
+
+  return r->map + r->slot * r->stride;
+}
+
+void ubo_ring_bind(ubo_ring *r, u32 binding) {
+  gl_bind_buffer_range(GL_UNIFORM_BUFFER, binding, r->buf.id,
+                       r->slot * r->stride, r->size);
+}
+
+void ubo_ring_fence(ubo_ring *r) {
+  if (r->fences[r->slot]) gl_delete_sync(r->fences[r->slot]);
+  r->fences[r->slot] = gl_fence_sync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
 void buf_data_n(buf *b, u32 usage, ssize_t elem_size, ssize_t n,
                 void *data) {
   buf_data(b, usage, n * elem_size, data);
@@ -727,9 +769,8 @@ shdr *mod_get_sh(draw_src s, cam *c, mtl m, m4 t) {
 
   shdr *cur = s == ds_cam ? cam : shade;
 
-  shdr_m4f(cur, "u_vp", c->vp);
   shdr_3f(cur, "u_eye", cam_get_eye(c));
-  shdr_1f(cur, "u_time", app_now() / 1000.f);
+  shdr_1f(cur, "u_time", app_secs(wind_period));
   shdr_m4f(cur, "u_model", t);
   shdr_3f(cur, "u_light_model", m.light_model);
   shdr_3f(cur, "u_light", dreamy_haze[m.light]);
@@ -763,11 +804,14 @@ void cam_make_frustum(cam *c) {
   f->bottom = plane_new(eye, v3_cross(v3_add(front, v3_mul(c->up, half_v)),
                                       c->right));
 
+  // widened by cam_latch_slack on every side. the eye swings around pos as
+  // the camera turns, so the apex is pulled back far enough to cover that too
   f = &c->frustum_cam;
-  half_v = cam_far * tanf(c->zoom * .5f);
-  half_h = half_v * c->aspect;
+  float slack = rad(cam_latch_slack), half = rad(c->zoom) * .5f;
+  half_v = cam_far * tanf(half + slack);
+  half_h = cam_far * tanf(atanf(tanf(half) * c->aspect) + slack);
   front = v3_mul(c->front, cam_far);
-  eye = cam_get_eye(c);
+  eye = v3_sub(cam_get_eye(c), v3_mul(c->front, c->dist * slack / tanf(half)));
 
   f->near = plane_new(v3_add(eye, v3_mul(c->front, cam_near)), c->front);
   f->far = plane_new(v3_add(eye, front), v3_neg(c->front));
@@ -783,7 +827,7 @@ void cam_make_frustum(cam *c) {
                                       c->right));
 }
 
-void cam_rot(cam *c) {
+v3 cam_dir(float yaw, float pitch) {
   // ok how does this work?
   // we take the cosine of the yaw for x, that makes sense. then we multiply by
   //     the cosine of the pitch. this makes it project onto that vector.
@@ -791,18 +835,16 @@ void cam_rot(cam *c) {
   // we take the sine of the yaw for z, and project it onto the pitch vector.
   // ok, now it all makes sense!
 
-  c->yaw = lerp(c->yaw, c->target_yaw, 0.5f);
-  c->pitch = lerp(c->pitch, c->target_pitch, 0.5f);
-
-  float yaw = c->yaw;
-  float pitch = c->pitch;
-
-  v3 front = v3_normed((v3){
+  return v3_normed((v3){
     cosf(rad(yaw)) * cosf(rad(pitch)),
     sinf(rad(pitch)),
     sinf(rad(yaw)) * cosf(rad(pitch))
   });
+}
 
+// front, right, up and vp from yaw and pitch.
+static void cam_orient(cam *c) {
+  v3 front = cam_dir(c->yaw, c->pitch);
   c->front = front;
 
   v3 right = v3_cross(front, c->world_up);
@@ -814,38 +856,38 @@ void cam_rot(cam *c) {
   m4 look = cam_get_look(c);
   m4 proj = cam_get_proj(c);
   c->vp = m4_mul(look, proj);
+}
+
+void cam_latch(cam *c, float yaw, float pitch) {
+  // any further and the camera pass would turn past the culled frustum, the
+  // rest of the turn shows up in the next frame's cam_rot
+  c->yaw += clamp((c->target_yaw - yaw) * 0.5f, -cam_latch_slack,
+                  cam_latch_slack);
+  c->pitch += clamp((c->target_pitch - pitch) * 0.5f, -cam_latch_slack,
+                    cam_latch_slack);
+  cam_orient(c);
+}
+
+void cam_rot(cam *c) {
+  c->yaw = lerp(c->yaw, c->target_yaw, 0.5f);
+  c->pitch = lerp(c->pitch, c->target_pitch, 0.5f);
+  cam_orient(c);
 
   float const overshoot_dist = 1.33f;
   float const overshoot_fov = 1.33f;
 
-  look = m4_look(v3_sub(c->pos, v3_mul(c->front, c->dist * overshoot_dist)),
-                 c->front,
-                 c->up);
-  proj = m4_persp(rad(c->zoom * overshoot_fov), c->aspect * overshoot_fov,
-                  0.01f,
-                  sqrtf(2.f) * 0.5f * chunk_size * world_draw_dist *
-                  overshoot_dist);
+  m4 look = m4_look(
+    v3_sub(c->pos, v3_mul(c->front, c->dist * overshoot_dist)), c->front,
+    c->up);
+  m4 proj = m4_persp(rad(c->zoom * overshoot_fov), c->aspect * overshoot_fov,
+                     0.01f,
+                     sqrtf(2.f) * 0.5f * chunk_size * world_draw_dist *
+                     overshoot_dist);
   c->cvp = m4_mul(look, proj);
 
   cam_make_frustum(c);
 }
 
-int *quad_indices(int w, int h) {
-  int *inds = arr_new_sized(int, (w - 1) * (h - 1) * 6);
-
-  for (int i = 0; i < h - 1; i++)
-    for (int j = 0; j < w - 1; j++) {
-      arr_add(&inds, &(int){(i + 1) * w + j + 1});
-      arr_add(&inds, &(int){(i + 1) * w + j});
-      arr_add(&inds, &(int){i * w + j});
-      arr_add(&inds, &(int){i * w + j});
-      arr_add(&inds, &(int){i * w + j + 1});
-      arr_add(&inds, &(int){(i + 1) * w + j + 1});
-    }
-
-  return inds;
-}
-
 void imod_opti_vao(vao *v, buf *model, buf *id) {
   gl_vertex_array_vertex_buffer(v->id, 1, model->id, 0, sizeof(m4));
   for (int i = 0; i < 4; i++) {
@@ -946,7 +988,6 @@ shdr *imod_get_sh(draw_src s, cam *c, mtl m) {
 
   shdr *cur = s == ds_cam ? cam : shade;
 
-  shdr_m4f(cur, "u_vp", c->vp);
   shdr_3f(cur, "u_eye", cam_get_eye(c));
   shdr_3f(cur, "u_light_model", m.light_model);
   shdr_3f(cur, "u_light", dreamy_haze[m.light]);
@@ -955,7 +996,7 @@ shdr *imod_get_sh(draw_src s, cam *c, mtl m) {
   shdr_1f(cur, "u_shine", m.shine);
   shdr_1f(cur, "u_wind", m.wind);
   shdr_1f(cur, "u_alpha", m.alpha);
-  shdr_1f(cur, "u_time", app_now() / 1000.f);
+  shdr_1f(cur, "u_time", app_secs(wind_period));
   shdr_bind(cur);
 
   return cur;
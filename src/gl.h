@@ -32,6 +32,12 @@ typedef struct frustum {
   plane top, bottom, left, right, far, near;
 } frustum;
 
+// the uniform block binding res/cam.glsl reads u_vp from, in every pass
+#define cam_vp_binding 0
+// how far, in degrees, the camera may turn between culling and cam_latch.
+// the camera pass's frustum is widened by this much
+#define cam_latch_slack 6.f
+
 typedef struct cam {
   v3 pos, front, up, right, world_up;
   float target_yaw, yaw, target_pitch, pitch, zoom, aspect, ortho_size, dist;
@@ -47,8 +53,17 @@ cam cam_new(v3 pos, v3 world_up, float yaw, float pitch, float aspect);
 
 void cam_tick(cam *c);
 
+// the unit front of a camera at yaw and pitch, in degrees.
+v3 cam_dir(float yaw, float pitch);
+
 void cam_rot(cam *c);
 
+// turns c by however far its target moved away from yaw and pitch since the
+// last cam_rot, as cam_rot would have, and redoes vp. the turn is clamped to
+// cam_latch_slack and the frustums are left as they were, so culling already
+// done still holds.
+void cam_latch(cam *c, float yaw, float pitch);
+
 v3 cam_get_eye(cam *c);
 
 m4 cam_get_look(cam *c);
@@ -106,6 +121,32 @@ void buf_data(buf *b, u32 usage, ssize_t size_in_bytes, void *data);
 
 void buf_bind(buf *b);
 
+// frames the gpu may still be reading a ubo_ring slot from
+#define ubo_ring_n 3
+
+// a small uniform block written straight through a persistent mapping, a
+// slot per frame in flight so a write never races a draw still reading it.
+typedef struct ubo_ring {
+  buf buf;
+  u8 *map;
+  // slot size, rounded up to the uniform buffer offset alignment
+  size_t size, stride;
+  int slot;
+  GLsync fences[ubo_ring_n];
+} ubo_ring;
+
+ubo_ring ubo_ring_new(size_t size);
+
+// moves on to the next slot, waiting for the gpu to be done with it, and
+// returns it for writing.
+void *ubo_ring_next(ubo_ring *r);
+
+// binds the current slot to the uniform block binding.
+void ubo_ring_bind(ubo_ring *r, u32 binding);
+
+// the current slot is free again once the draws issued so far finish.
+void ubo_ring_fence(ubo_ring *r);
+
 typedef struct attrib {
   int size;
   u32 type;
@@ -284,10 +325,8 @@ typedef struct dither {
 
 void dither_up(shdr *s, dither args);
 
-typedef struct obj_vtx {
-  v3 pos;
-  v3 norm;
-} obj_vtx;
+// every sine in res/wind.glsl repeats after this many seconds, 2pi / .75
+#define wind_period 8.37758041
 
 typedef struct mtl {
   u32 light, dark;
@@ -355,5 +394,3 @@ void imod_draw(draw_src s, cam *c);
 void imod_add(imod *m, m4 t, int id);
 
 mod mod_new_indirect_mtl(const char *path, const char *mtl);
-
-int *quad_indices(int w, int h);
\ No newline at end of file
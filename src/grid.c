@@ -0,0 +1,647 @@
+#include "grid.h"
+#include "arr.h"
+#include <stdatomic.h>
+#include "dda.h"
+
+static iv3 grid_cell(grid_layer *l, v3 pos) {
+  return (iv3){(int)floorf(pos.x / l->cell_size),
+               l->flat ? 0 : (int)floorf(pos.y / l->cell_size),
+               (int)floorf(pos.z / l->cell_size)};
+}
+
+static grid_layer grid_layer_new(float cell_size, bool flat) {
+  return (grid_layer){
+    .cells = map_new(256, sizeof(iv3), sizeof(int *), 0.5f, iv3_peq, iv3_hash),
+    .cell_size = cell_size,
+    .flat = flat,
+  };
+}
+
+static grid_layer *grid_layer_of(grid *g, proxy *p) {
+  return p->dyn ? &g->dyn : &g->sta;
+}
+
+static bool grid_cells_have(iv3 min, iv3 max, iv3 cell) {
+  return cell.x >= min.x && cell.x <= max.x && cell.y >= min.y &&
+         cell.y <= max.y && cell.z >= min.z && cell.z <= max.z;
+}
+
+// a range of cells that has none
+#define grid_no_cells (iv3){1, 1, 1}, (iv3){}
+
+// bins h in its cells, but those from keep_min to keep_max, where it already
+// is. so a body stepping over a cell face only touches the cells it gained
+static void grid_bin(grid *g, int h, iv3 keep_min, iv3 keep_max) {
+  proxy *p = &g->proxies[h];
+  grid_layer *l = grid_layer_of(g, p);
+  for (int i = p->min.x; i <= p->max.x; i++) {
+    for (int j = p->min.y; j <= p->max.y; j++) {
+      for (int k = p->min.z; k <= p->max.z; k++) {
+        iv3 cell = {i, j, k};
+        if (grid_cells_have(keep_min, keep_max, cell)) continue;
+
+        int **hs = map_at(&l->cells, &cell);
+        if (!hs) {
+          int *empty = arr_new(int);
+          hs = map_add(&l->cells, &cell, &empty);
+        }
+
+        arr_add(hs, &h);
+      }
+    }
+  }
+}
+
+// unbins h from its cells, but those from keep_min to keep_max
+static void grid_unbin(grid *g, int h, iv3 keep_min, iv3 keep_max) {
+  proxy *p = &g->proxies[h];
+  grid_layer *l = grid_layer_of(g, p);
+  for (int i = p->min.x; i <= p->max.x; i++) {
+    for (int j = p->min.y; j <= p->max.y; j++) {
+      for (int k = p->min.z; k <= p->max.z; k++) {
+        iv3 cell = {i, j, k};
+        if (grid_cells_have(keep_min, keep_max, cell)) continue;
+
+        int **hs = map_at(&l->cells, &cell);
+        if (!hs) continue;
+
+        int *cell_hs = *hs;
+        for (size_t n = 0; n < arr_len(cell_hs); n++) {
+          if (cell_hs[n] != h) continue;
+          cell_hs[n] = *arr_last(cell_hs);
+          arr_len(cell_hs)--;
+          break;
+        }
+
+        // empty cells go, so memory follows what's loaded
+        if (arr_is_empty(cell_hs)) {
+          arr_del(cell_hs);
+          map_remove(&l->cells, &cell);
+        }
+      }
+    }
+  }
+}
+
+static int grid_alloc(grid *g, proxy p) {
+  grid_layer *l = grid_layer_of(g, &p);
+  p.min = grid_cell(l, p.box.min);
+  p.max = grid_cell(l, p.box.max);
+  p.gen = ++g->n_gens;
+
+  int h;
+  if (!arr_is_empty(g->free)) {
+    h = *arr_last(g->free);
+    arr_len(g->free)--;
+    g->proxies[h] = p;
+  } else {
+    h = arr_len(g->proxies);
+    arr_add(&g->proxies, &p);
+  }
+
+  grid_bin(g, h, grid_no_cells);
+  return h;
+}
+
+grid grid_new() {
+  grid g = {
+    .sta = grid_layer_new(grid_sta_cell_size, 1),
+    .dyn = grid_layer_new(grid_dyn_cell_size, 0),
+    .proxies = arr_new(proxy),
+    .free = arr_new(int),
+    .active = arr_new(int),
+    .pairs = arr_new(pair),
+    .batches = arr_new(batch),
+    .n_ticks = 1,
+    .contacts = map_new(256, sizeof(iv2), sizeof(contact), 0.5f, iv2_peq,
+                        iv2_hash),
+    .islands = arr_new(int *),
+    .free_islands = arr_new(int),
+    .woken = arr_new(int),
+    .uf = arr_new(int),
+    .uf_island = arr_new(int),
+  };
+
+  arr_add(&g.proxies, &(proxy){});
+  return g;
+}
+
+// the ground under sleeping bodies changed
+static void grid_wake_near(grid *g, int h) {
+  proxy *p = &g->proxies[h];
+  iv3 min = grid_cell(&g->dyn, p->box.min), max = grid_cell(&g->dyn, p->box.max);
+  for (int i = min.x; i <= max.x; i++) {
+    for (int j = min.y; j <= max.y; j++) {
+      for (int k = min.z; k <= max.z; k++) {
+        int **hs = map_at(&g->dyn.cells, &(iv3){i, j, k});
+        if (!hs) continue;
+
+        for (int *o = *hs, *end = arr_end(*hs); o != end; o++) {
+          proxy *q = &g->proxies[*o];
+          if (q->asleep && box3_overlaps(p->box, q->box)) grid_wake(g, *o);
+        }
+      }
+    }
+  }
+}
+
+int grid_add_sta(grid *g, body *o, int id) {
+  int h = grid_alloc(g, (proxy){.sta = *o, .box = body_get_box(o), .id = id});
+  grid_wake_near(g, h);
+  return h;
+}
+
+int grid_add_dyn(grid *g, body *o, int id, int k) {
+  return grid_alloc(g, (proxy){
+    .dyn = o,
+    .kin = k,
+    .box = box3_grow(body_get_box(o), grid_margin),
+    .id = id,
+  });
+}
+
+void grid_remove(grid *g, int h) {
+  proxy *p = &g->proxies[h];
+  if (!p->dyn) {
+    grid_wake_near(g, h);
+  } else if (p->asleep) {
+    int *members = g->islands[p->island];
+    for (size_t i = 0; i < arr_len(members); i++) {
+      if (members[i] != h) continue;
+      members[i] = *arr_last(members);
+      arr_len(members)--;
+      break;
+    }
+  }
+
+  grid_unbin(g, h, grid_no_cells);
+  g->proxies[h] = (proxy){};
+  arr_add(&g->free, &h);
+}
+
+void grid_begin(grid *g) {
+  arr_clear(g->active);
+  arr_clear(g->woken);
+  g->n_ticks++;
+}
+
+bool grid_is_moved(grid *g, int h) {
+  return g->proxies[h].moved == g->n_ticks;
+}
+
+bool grid_is_asleep(grid *g, int h) {
+  return g->proxies[h].asleep;
+}
+
+void grid_track(grid *g, int h, body *o) {
+  g->proxies[h].dyn = o;
+}
+
+void grid_wake(grid *g, int h) {
+  proxy *p = &g->proxies[h];
+  if (!p->asleep) return;
+
+  int island = p->island;
+  int *members = g->islands[island];
+  for (int *m = members, *end = arr_end(members); m != end; m++) {
+    g->proxies[*m].asleep = 0;
+    g->proxies[*m].still = 0;
+    arr_add(&g->woken, m);
+  }
+
+  arr_clear(g->islands[island]);
+  arr_add(&g->free_islands, &island);
+}
+
+void grid_move(grid *g, int h, body *o, v3 sweep) {
+  proxy *p = &g->proxies[h];
+  p->dyn = o;
+  if (p->moved != g->n_ticks) {
+    p->moved = g->n_ticks;
+    arr_add(&g->active, &h);
+  }
+
+  box3 box = body_get_box(o);
+  p->swept = box = box3_fit(box, box3_add(box, sweep));
+  if (box3_inside(p->box, box)) return;
+
+  p->box = box3_grow(box, grid_margin);
+  iv3 min = grid_cell(&g->dyn, p->box.min), max = grid_cell(&g->dyn, p->box.max);
+  if (iv3_eq(min, p->min) && iv3_eq(max, p->max)) return;
+
+  iv3 old_min = p->min, old_max = p->max;
+  grid_unbin(g, h, min, max);
+  p->min = min;
+  p->max = max;
+  grid_bin(g, h, old_min, old_max);
+}
+
+// wider than two cells a side, so it could be in two cells of one color
+static bool proxy_is_big(proxy *p) {
+  return p->max.x - p->min.x > 1 || p->max.y - p->min.y > 1 ||
+         p->max.z - p->min.z > 1;
+}
+
+static int pair_cmp(void const *ap, void const *bp) {
+  pair const *a = ap, *b = bp;
+  if (a->color != b->color) return a->color - b->color;
+  for (int i = 0; i < 3; i++) {
+    if (a->cell.v[i] != b->cell.v[i]) return a->cell.v[i] < b->cell.v[i] ? -1 : 1;
+  }
+  // statics first within a cell, like the regions used to
+  if (a->sta != b->sta) return b->sta - a->sta;
+  return a->seq - b->seq;
+}
+
+// finds each pair's contact, and forgets those of pairs that split up
+static void grid_contacts(grid *g) {
+  for (pair *p = g->pairs, *end = arr_end(g->pairs); p != end; p++) {
+    unsigned gen_a = g->proxies[p->ha].gen, gen_b = g->proxies[p->hb].gen;
+    contact *c = map_at(&g->contacts, &(iv2){p->ha, p->hb});
+    if (!c) {
+      c = map_add(&g->contacts, &(iv2){p->ha, p->hb}, &(contact){});
+    } else if (c->gen_a != gen_a || c->gen_b != gen_b) {
+      tri_cache_del(&c->tris);
+      *c = (contact){};
+    }
+
+    c->gen_a = gen_a, c->gen_b = gen_b;
+    c->seen = g->n_ticks;
+  }
+
+  // back to front, since removing moves the last entry into the gap
+  for (int i = (int)g->contacts.count - 1; i >= 0; i--) {
+    contact *c = (contact *)g->contacts.vals + i;
+    if (c->seen == g->n_ticks) continue;
+
+    tri_cache_del(&c->tris);
+    iv2 key = ((iv2 *)g->contacts.keys)[i];
+    map_remove(&g->contacts, &key);
+  }
+
+  for (pair *p = g->pairs, *end = arr_end(g->pairs); p != end; p++) {
+    p->contact = map_at(&g->contacts, &(iv2){p->ha, p->hb});
+  }
+}
+
+static void grid_batch(grid *g) {
+  qsort(g->pairs, arr_len(g->pairs), sizeof(pair), pair_cmp);
+  grid_contacts(g);
+
+  arr_clear(g->batches);
+  int color = 0;
+  g->color_first[0] = 0;
+  for (int i = 0, len = arr_len(g->pairs); i < len; i++) {
+    pair *p = &g->pairs[i];
+    while (color < p->color) g->color_first[++color] = arr_len(g->batches);
+
+    batch *last = arr_is_empty(g->batches) ? NULL : arr_last(g->batches);
+    if (last && last->first + last->count == i &&
+        p->color == g->pairs[last->first].color &&
+        iv3_eq(p->cell, g->pairs[last->first].cell)) {
+      last->count++;
+    } else {
+      arr_add(&g->batches, &(batch){i, 1});
+    }
+  }
+
+  while (color <= grid_n_colors) g->color_first[++color] = arr_len(g->batches);
+}
+
+// the pair of q and p, which was moved. it's owned by the dynamic cell their
+// overlap starts in, which p covers, and q too if it's dynamic
+static void grid_pair(grid *g, int hq, int hp) {
+  proxy *p = &g->proxies[hp], *q = &g->proxies[hq];
+  iv3 cell = grid_cell(&g->dyn, v3_max(p->box.min, q->box.min));
+  bool q_sta = !q->dyn || q->asleep;
+  bool big = proxy_is_big(p) || (!q_sta && proxy_is_big(q));
+  arr_add(&g->pairs, &(pair){
+    .a = q->dyn ? q->dyn : &q->sta,
+    .b = p->dyn,
+    .ka = q->kin,
+    .kb = p->kin,
+    .ha = hq,
+    .hb = hp,
+    .cell = cell,
+    .color = big ? grid_n_colors :
+             (cell.x & 1) | (cell.y & 1) << 1 | (cell.z & 1) << 2,
+    .sta = q_sta,
+    .seq = arr_len(g->pairs),
+  });
+}
+
+bool grid_pairs(grid *g) {
+  arr_clear(g->pairs);
+  size_t n_woken = arr_len(g->woken);
+
+  for (int *h = g->active, *end = arr_end(g->active); h != end; h++) {
+    proxy *p = &g->proxies[*h];
+    // removed since it was moved
+    if (p->moved != g->n_ticks) continue;
+
+    // statics, from the columns under p
+    iv3 min = grid_cell(&g->sta, p->box.min), max = grid_cell(&g->sta, p->box.max);
+    for (int i = min.x; i <= max.x; i++) {
+      for (int k = min.z; k <= max.z; k++) {
+        iv3 cell = {i, 0, k};
+        int **hs = map_at(&g->sta.cells, &cell);
+        if (!hs) continue;
+
+        for (int *o = *hs, *o_end = arr_end(*hs); o != o_end; o++) {
+          proxy *q = &g->proxies[*o];
+          if (!box3_overlaps(p->box, q->box)) continue;
+
+          // a pair shows up in every cell both cover, keep it in the one
+          // where their overlap starts
+          v3 start = v3_max(p->box.min, q->box.min);
+          if (!iv3_eq(grid_cell(&g->sta, start), cell)) continue;
+          grid_pair(g, *o, *h);
+        }
+      }
+    }
+
+    // dynamics, from the cells p is binned in
+    for (int i = p->min.x; i <= p->max.x; i++) {
+      for (int j = p->min.y; j <= p->max.y; j++) {
+        for (int k = p->min.z; k <= p->max.z; k++) {
+          iv3 cell = {i, j, k};
+          int **hs = map_at(&g->dyn.cells, &cell);
+
+          for (int *o = *hs, *o_end = arr_end(*hs); o != o_end; o++) {
+            if (*o == *h) continue;
+            proxy *q = &g->proxies[*o];
+            // slow bodies lean on sleeping ones as if they were static, so a
+            // pile can settle around something still rolling. fast ones only
+            // wake them if their sweep this tick reaches them, not the margin
+            if (q->asleep && v3_len(p->dyn->vel) >= grid_wake_speed &&
+                box3_overlaps(p->swept, body_get_box(q->dyn))) {
+              grid_wake(g, *o);
+              continue;
+            }
+
+            // two moved bodies only pair up from the lower handle
+            if (q->dyn && q->moved == g->n_ticks && *o < *h) continue;
+            if (!box3_overlaps(p->box, q->box)) continue;
+
+            v3 start = v3_max(p->box.min, q->box.min);
+            if (!iv3_eq(grid_cell(&g->dyn, start), cell)) continue;
+            grid_pair(g, *o, *h);
+          }
+        }
+      }
+    }
+  }
+
+  if (arr_len(g->woken) > n_woken) return 1;
+
+  grid_batch(g);
+  return 0;
+}
+
+void grid_sweep(grid *g, kin *k, int s) {
+  for (pair *p = g->pairs, *end = arr_end(g->pairs); p != end; p++) {
+    if (!p->sta || !k->fast[p->kb] || !kin_steps_at(k, p->kb, s)) continue;
+
+    kin_load(k, p->kb);
+    float dt = k->dt[p->kb] * k->toi[p->kb];
+    k->toi[p->kb] *= body_toi(p->a, p->b, v3_mul(p->b->vel, dt));
+  }
+}
+
+// the pair's last hit if neither body has moved far since, with the depth
+// following them along its normal. otherwise, or if that depth runs out,
+// tests again, since a resting body can still touch along another normal
+static hit grid_hit(pair *p) {
+  contact *c = p->contact;
+  v3 a_moved = v3_sub(p->a->pos, c->a_pos), b_moved = v3_sub(p->b->pos, c->b_pos);
+
+  if (c->h.is_hit && v3_len(a_moved) < grid_contact_slop &&
+      v3_len(b_moved) < grid_contact_slop) {
+    hit h = c->h;
+    h.push -= v3_dot(v3_sub(b_moved, a_moved), h.norm);
+    if (h.push > 0) return h;
+  }
+
+  c->a_pos = p->a->pos, c->b_pos = p->b->pos;
+  c->h = p->sta ? body_hit_cached(p->a, p->b, &c->tris) : body_hit(p->a, p->b);
+  return c->h;
+}
+
+static void grid_solve_batch(grid *g, kin *k, int s, batch *b) {
+  for (pair *p = &g->pairs[b->first], *end = p + b->count; p != end; p++) {
+    // neither body moved in this substep
+    if (!kin_steps_at(k, p->kb, s) &&
+        (p->sta || !kin_steps_at(k, p->ka, s))) continue;
+
+    if (!p->sta) kin_load(k, p->ka);
+    kin_load(k, p->kb);
+
+    hit h = grid_hit(p);
+    if (!h.is_hit) continue;
+    p->touched = 1;
+
+    if (p->sta) {
+      body_response(p->b, h, sqrtf(p->a->slip * p->b->slip));
+      kin_store(k, p->kb);
+      continue;
+    }
+
+    hit a_hit = h, b_hit = h;
+    a_hit.push *= -0.5f, b_hit.push *= 0.5f;
+
+    body_response(p->a, a_hit, sqrtf(p->a->slip * p->b->slip));
+    body_response(p->b, b_hit, sqrtf(p->a->slip * p->b->slip));
+    kin_store(k, p->ka);
+    kin_store(k, p->kb);
+  }
+}
+
+typedef struct solve_job {
+  grid *grid;
+  kin *kin;
+  int s;
+  int _Atomic next;
+  int end;
+} solve_job;
+
+static void grid_solve_job(void *ctx, int worker) {
+  solve_job *job = ctx;
+  for (int i; (i = atomic_fetch_add(&job->next, 1)) < job->end;) {
+    grid_solve_batch(job->grid, job->kin, job->s, &job->grid->batches[i]);
+  }
+}
+
+void grid_solve(grid *g, pool *p, kin *k, int s) {
+  // past the first substeps usually only a few fast bodies step and every
+  // other pair is skipped right away, not worth a wake per color
+  int par_min = grid_par_min * p->n_workers;
+  bool par = k->n_at[s] >= par_min;
+
+  for (int c = 0; c <= grid_n_colors; c++) {
+    int first = g->color_first[c], end = g->color_first[c + 1];
+    if (first == end) continue;
+
+    // big bodies are always solved on their own
+    int n_pairs = end == arr_len(g->batches) ?
+      arr_len(g->pairs) - g->batches[first].first :
+      g->batches[end].first - g->batches[first].first;
+    if (!par || c == grid_n_colors || n_pairs < par_min) {
+      for (int i = first; i < end; i++) grid_solve_batch(g, k, s, &g->batches[i]);
+      continue;
+    }
+
+    solve_job job = {.grid = g, .kin = k, .s = s, .next = first, .end = end};
+    pool_run(p, grid_solve_job, &job);
+  }
+}
+
+// grid_cast over one layer, keeping whatever beats best.
+static void grid_cast_layer(grid *g, grid_layer *l, v3 o, v3 d, float r,
+                            int ignore, ray_hit *best, int *h) {
+  v3 inv_d = {1.f / d.x, 1.f / d.y, 1.f / d.z};
+
+  // bodies within r of the ray's cell can be touched too
+  int reach = (int)ceilf(r / l->cell_size);
+  dda walk = dda_new(o, d, 0, v2_zero, l->cell_size);
+  while (walk.t <= best->t) {
+    // the heights the ray passes through while it's over this column
+    int y_min = 0, y_max = 0;
+    if (!l->flat) {
+      float y0 = o.y + d.y * walk.t,
+        y1 = o.y + d.y * fminf(dda_exit(&walk), best->t);
+      y_min = (int)floorf(fminf(y0, y1) / l->cell_size) - reach;
+      y_max = (int)floorf(fmaxf(y0, y1) / l->cell_size) + reach;
+    }
+
+    for (int i = walk.cell.x - reach; i <= walk.cell.x + reach; i++) {
+      for (int j = y_min; j <= y_max; j++) {
+        for (int k = walk.cell.y - reach; k <= walk.cell.y + reach; k++) {
+          int **hs = map_at(&l->cells, &(iv3){i, j, k});
+          if (!hs) continue;
+
+          // bodies in several cells are tested again, they just can't win
+          for (int *q = *hs, *end = arr_end(*hs); q != end; q++) {
+            proxy *p = &g->proxies[*q];
+            if (*q == ignore ||
+                !box3_ray(box3_grow(p->box, r), o, inv_d, best->t)) continue;
+
+            ray_hit hit = body_sweep(p->dyn ? p->dyn : &p->sta, o, d, best->t,
+                                     r);
+            if (!hit.is_hit || (best->is_hit && hit.t >= best->t)) continue;
+            *best = hit;
+            *h = *q;
+          }
+        }
+      }
+    }
+
+    // later cells can't be closer
+    if (best->is_hit && best->t <= dda_exit(&walk)) break;
+    dda_next(&walk);
+  }
+}
+
+ray_hit grid_cast(grid *g, v3 o, v3 d, float l, float r, int ignore, int *h) {
+  ray_hit best = {.t = l};
+  *h = 0;
+
+  // statics first, they usually end the ray early for the finer walk
+  grid_cast_layer(g, &g->sta, o, d, r, ignore, &best, h);
+  grid_cast_layer(g, &g->dyn, o, d, r, ignore, &best, h);
+  return best;
+}
+
+// grid_overlap over one layer.
+static void grid_overlap_layer(grid *g, grid_layer *l, box3 box, int **hs) {
+  iv3 min = grid_cell(l, box.min), max = grid_cell(l, box.max);
+  for (int i = min.x; i <= max.x; i++) {
+    for (int j = min.y; j <= max.y; j++) {
+      for (int k = min.z; k <= max.z; k++) {
+        iv3 cell = {i, j, k};
+        int **in = map_at(&l->cells, &cell);
+        if (!in) continue;
+
+        for (int *q = *in, *end = arr_end(*in); q != end; q++) {
+          proxy *p = &g->proxies[*q];
+          if (!box3_overlaps(p->box, box)) continue;
+          // only counted in the cell where the overlap starts, like pairs
+          v3 start = v3_max(p->box.min, box.min);
+          if (!iv3_eq(grid_cell(l, start), cell)) continue;
+
+          if (body_overlaps_box(p->dyn ? p->dyn : &p->sta, box)) arr_add(hs, q);
+        }
+      }
+    }
+  }
+}
+
+void grid_overlap(grid *g, box3 box, int **hs) {
+  grid_overlap_layer(g, &g->sta, box, hs);
+  grid_overlap_layer(g, &g->dyn, box, hs);
+}
+
+static int uf_find(int *uf, int i) {
+  while (uf[i] != i) {
+    uf[i] = uf[uf[i]];
+    i = uf[i];
+  }
+
+  return i;
+}
+
+void grid_settle(grid *g) {
+  int n = 0;
+  for (int *h = g->active, *end = arr_end(g->active); h != end; h++) {
+    n = max(n, g->proxies[*h].kin + 1);
+  }
+
+  arr_clear(g->uf);
+  arr_clear(g->uf_island);
+  for (int i = 0; i < n; i++) {
+    arr_add(&g->uf, &i);
+    // -1 while the island may still sleep, -2 once it can't
+    arr_add(&g->uf_island, &(int){-1});
+  }
+
+  for (int *h = g->active, *end = arr_end(g->active); h != end; h++) {
+    proxy *p = &g->proxies[*h];
+    bool still = v3_len(p->dyn->vel) < grid_sleep_speed;
+    p->still = still ? p->still + 1 : 0;
+  }
+
+  // islands only grow through bodies that have settled, so one that keeps
+  // jittering can't hold a whole pile awake. it leans on the pile once that
+  // sleeps, and wakes it if it hits hard enough
+  for (pair *p = g->pairs, *end = arr_end(g->pairs); p != end; p++) {
+    if (p->sta || !p->touched) continue;
+    if (g->proxies[p->ha].still < grid_sleep_ticks ||
+        g->proxies[p->hb].still < grid_sleep_ticks) continue;
+    int a = uf_find(g->uf, p->ka), b = uf_find(g->uf, p->kb);
+    if (a != b) g->uf[max(a, b)] = min(a, b);
+  }
+
+  for (int *h = g->active, *end = arr_end(g->active); h != end; h++) {
+    proxy *p = &g->proxies[*h];
+    if (p->still < grid_sleep_ticks) g->uf_island[uf_find(g->uf, p->kin)] = -2;
+  }
+
+  for (int *h = g->active, *end = arr_end(g->active); h != end; h++) {
+    proxy *p = &g->proxies[*h];
+    int *island = &g->uf_island[uf_find(g->uf, p->kin)];
+    if (*island == -2) continue;
+
+    if (*island == -1) {
+      if (!arr_is_empty(g->free_islands)) {
+        *island = *arr_last(g->free_islands);
+        arr_len(g->free_islands)--;
+      } else {
+        *island = arr_len(g->islands);
+        arr_add(&g->islands, &(int *){arr_new(int)});
+      }
+    }
+
+    p->asleep = 1;
+    p->island = *island;
+    arr_add(&g->islands[*island], h);
+  }
+}
@@ -0,0 +1,191 @@
+#pragma once
+
+#include "body.h"
+#include "map.h"
+#include "pool.h"
+#include "kin.h"
+
+/*-- a persistent spatial hash of bodies. --*/
+
+// statics are binned in columns a chunk wide, so a chunk's collider covers
+// few of them
+#define grid_sta_cell_size 8.f
+// dynamics are binned in cubes about as big as their grown boxes, so a moved
+// body only scans its neighbours, not the whole pile in its chunk. pairs are
+// owned and colored by these cells
+#define grid_dyn_cell_size 2.f
+// dynamic boxes are grown by this on top of a tick's motion, so slow bodies
+// only get rebinned every few ticks
+#define grid_margin 0.125f
+// dynamic cells are solved in a 2x2x2 checkerboard. a body spanning at most
+// two cells a side can't be in two cells of one color, so those run in
+// parallel
+#define grid_n_colors 8
+// colors with fewer pairs than this per worker aren't worth waking the pool
+// for, each wake costs two barriers
+#define grid_par_min 64
+// a body slower than this per substep counts as still
+#define grid_sleep_speed 0.005f
+// bodies hitting sleeping ones any slower treat them as static
+#define grid_wake_speed (grid_sleep_speed * 2)
+// islands whose bodies have all been still this many ticks fall asleep
+#define grid_sleep_ticks 30
+// pairs whose bodies have both moved less than this since their last hit
+// reuse it instead of testing again
+#define grid_contact_slop 0.01f
+
+typedef struct proxy {
+  // what grid_pairs reads of every body in a cell comes first, so each one
+  // costs a single cache line
+  box3 box;
+  // dynamic bodies are pointed at, static ones are copied into sta
+  body *dyn;
+  // the grid tick this was last moved in
+  unsigned moved;
+  // sleeping bodies aren't moved, and stay in islands until one is woken
+  bool asleep;
+  // dyn's kin entry, held until it's removed
+  int kin;
+  // the range of cells box covers, in its layer
+  iv3 min, max;
+  // what dyn sweeps through this tick, box without the margin
+  box3 swept;
+  // ticks dyn has been still for
+  int still;
+  int island;
+  // tells bodies apart that get the same handle
+  unsigned gen;
+  // the id of whatever owns the body, for queries
+  int id;
+  body sta;
+} proxy;
+
+// what a pair's narrowphase last found, kept across substeps and ticks for as
+// long as the bodies stay paired. it's keyed by the pair, not by triangle:
+// the narrowphase sums every triangle's push into one and the response moves
+// the body once along it, so there's no per triangle impulse to warm start.
+// tris keeps the pair's candidate triangles, which a body moving past
+// grid_contact_slop is tested against again.
+typedef struct contact {
+  // the gens of a and b's proxies
+  unsigned gen_a, gen_b;
+  // where a and b were when h was found
+  v3 a_pos, b_pos;
+  hit h;
+  // the grid tick the pair was last found in
+  unsigned seen;
+  tri_cache tris;
+} contact;
+
+typedef struct pair {
+  body *a, *b;
+  // kin entries and handles of a and b, a's kin entry is unused when it's
+  // static
+  int ka, kb;
+  int ha, hb;
+  // the dynamic cell that owns the pair and its color, grid_n_colors if a
+  // body is too big to be solved alongside others
+  iv3 cell;
+  int color;
+  // b only pushes a if a is dynamic
+  bool sta;
+  // whether the bodies actually hit during grid_solve
+  bool touched;
+  int seq;
+  contact *contact;
+} pair;
+
+// a spatial hash of handles.
+typedef struct grid_layer {
+  // iv3 -> arr of handles
+  map cells;
+  float cell_size;
+  // cells are columns, y is always 0
+  bool flat;
+} grid_layer;
+
+// a run of pairs owned by one cell, solved in order by one thread.
+typedef struct batch {
+  int first, count;
+} batch;
+
+typedef struct grid {
+  // statics and dynamics are binned apart, at their own cell sizes
+  grid_layer sta, dyn;
+  // indexed by handle. slot 0 is never used, so a zeroed handle means none
+  proxy *proxies;
+  int *free;
+  // handles moved this tick
+  int *active;
+  // what grid_pairs found, sorted into batches by color then cell. static
+  // bodies always come as a
+  pair *pairs;
+  batch *batches;
+  // batches of color c are [color_first[c], color_first[c + 1])
+  int color_first[grid_n_colors + 2];
+  unsigned n_ticks, n_gens;
+  // iv2 {ha, hb} -> contact
+  map contacts;
+
+  // arrs of the handles in each sleeping island, emptied ones are reused
+  int **islands;
+  int *free_islands;
+  // woken since the last grid_begin, they still have to be moved
+  int *woken;
+  // scratch for grid_settle, indexed by kin entry
+  int *uf, *uf_island;
+} grid;
+
+grid grid_new();
+
+// copies o, returns its handle. id is handed back by queries.
+int grid_add_sta(grid *g, body *o, int id);
+
+// o has to go through grid_move every tick, since it may move in memory. its
+// motion lives in kin entry k while it moves.
+int grid_add_dyn(grid *g, body *o, int id, int k);
+
+void grid_remove(grid *g, int h);
+
+// starts a tick, nothing has been moved yet.
+void grid_begin(grid *g);
+
+// o is at its current address, and moves by at most sweep this tick. only
+// rebins it when that leaves the cells it's in.
+void grid_move(grid *g, int h, body *o, v3 sweep);
+
+bool grid_is_moved(grid *g, int h);
+
+bool grid_is_asleep(grid *g, int h);
+
+// updates a sleeping body's address without waking it.
+void grid_track(grid *g, int h, body *o);
+
+// wakes h's whole island and adds it to woken.
+void grid_wake(grid *g, int h);
+
+// finds every overlapping pair with a body moved this tick, each only once
+// even when it spans several cells. sleeping bodies touched by moved ones are
+// woken instead, and 1 is returned so they can be moved and this rerun.
+bool grid_pairs(grid *g);
+
+// shortens substep s for fast bodies in k that would pass through the static
+// bodies they're paired with. runs before kin_integrate.
+void grid_sweep(grid *g, kin *k, int s);
+
+// resolves the pairs from the last grid_pairs with a body stepping in
+// substep s, a color at a time across p, with dynamic bodies' motion living
+// in k. gives the same result however many workers p has.
+void grid_solve(grid *g, pool *p, kin *k, int s);
+
+// the closest body a ball of radius r swept from o along the unit dir d for up
+// to l hits, skipping handle ignore. walks the cells under the ray, so only
+// bodies near it are tested. *h is 0 on a miss.
+ray_hit grid_cast(grid *g, v3 o, v3 d, float l, float r, int ignore, int *h);
+
+// adds the handle of every body overlapping box to the arr hs, once each.
+void grid_overlap(grid *g, box3 box, int **hs);
+
+// puts islands of bodies moved this tick to sleep once they've all been still
+// long enough. islands are joined by the pairs that touched.
+void grid_settle(grid *g);
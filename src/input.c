@@ -0,0 +1,58 @@
+#include "input.h"
+#include <stdatomic.h>
+#include <string.h>
+
+bool input_push(input_ring *r, input_ev ev) {
+  size_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+  if (head - atomic_load_explicit(&r->tail, memory_order_acquire) ==
+      input_cap) {
+    return 0;
+  }
+
+  r->evs[head & (input_cap - 1)] = ev;
+  atomic_store_explicit(&r->head, head + 1, memory_order_release);
+  return 1;
+}
+
+static void input_apply(input_state *s, input_ev *ev) {
+  switch (ev->kind) {
+    case ik_key: {
+      if (ev->code < 0 || ev->code > GLFW_KEY_LAST) break;
+      s->keys[ev->code] = ev->action != GLFW_RELEASE;
+      if (ev->action == GLFW_PRESS) s->key_taps[ev->code] = 1;
+      break;
+    }
+    case ik_button: {
+      if (ev->code < 0 || ev->code > GLFW_MOUSE_BUTTON_LAST) break;
+      s->buttons[ev->code] = ev->action != GLFW_RELEASE;
+      break;
+    }
+    case ik_look: {
+      s->yaw = ev->yaw;
+      s->pitch = ev->pitch;
+      break;
+    }
+  }
+}
+
+void input_drain(input_ring *r, input_state *s, int64_t time) {
+  size_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed),
+    head = atomic_load_explicit(&r->head, memory_order_acquire);
+
+  for (; tail != head; tail++) {
+    input_ev *ev = &r->evs[tail & (input_cap - 1)];
+    if (ev->time > time) break;
+
+    input_apply(s, ev);
+  }
+
+  atomic_store_explicit(&r->tail, tail, memory_order_release);
+}
+
+bool input_is_down(input_state *s, int key) {
+  return s->keys[key] || s->key_taps[key];
+}
+
+void input_clear_taps(input_state *s) {
+  memset(s->key_taps, 0, sizeof(s->key_taps));
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stdint.h>
+#include "lib/glfw/include/GLFW/glfw3.h"
+#include "typedefs.h"
+
+/*-- input events handed from glfw's callbacks to the tick thread. --*/
+
+// a power of two. a tick only sees a handful of events, the rest is slack
+// for when the tick thread stalls
+#define input_cap 1024
+
+typedef enum input_kind {
+  ik_key,
+  ik_button,
+  ik_look
+} input_kind;
+
+typedef struct input_ev {
+  // ticker_now() when glfw reported it
+  int64_t time;
+  input_kind kind;
+  // the key or mouse button, and GLFW_PRESS, GLFW_RELEASE or GLFW_REPEAT
+  int code, action;
+  // the camera's target yaw and pitch after the motion, for ik_look
+  float yaw, pitch;
+} input_ev;
+
+// one thread pushes, another drains.
+typedef struct input_ring {
+  input_ev evs[input_cap];
+  // only the pusher writes head and only the drainer writes tail
+  size_t _Atomic head, tail;
+} input_ring;
+
+// what the drained events add up to.
+typedef struct input_state {
+  bool keys[GLFW_KEY_LAST + 1], buttons[GLFW_MOUSE_BUTTON_LAST + 1];
+  // pressed since the last input_clear_taps, so taps shorter than a tick
+  // still count
+  bool key_taps[GLFW_KEY_LAST + 1];
+  float yaw, pitch;
+} input_state;
+
+// drops ev and returns 0 when the ring is full.
+bool input_push(input_ring *r, input_ev ev);
+
+// applies the events up to time to s, in order. later ones stay queued.
+void input_drain(input_ring *r, input_state *s, int64_t time);
+
+// held down, or tapped since the last input_clear_taps.
+bool input_is_down(input_state *s, int key);
+
+void input_clear_taps(input_state *s);
@@ -0,0 +1,198 @@
+#include "kin.h"
+#include <stdlib.h>
+#include <string.h>
+#include "simd.h"
+#include "arr.h"
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+// the kernels load whole f8s, so every component starts on one
+static void *kin_alloc(size_t size) {
+#ifdef _WIN32
+  return _aligned_malloc(size, sizeof(f8));
+#else
+  return aligned_alloc(sizeof(f8), size);
+#endif
+}
+
+static void kin_free(void *p) {
+#ifdef _WIN32
+  _aligned_free(p);
+#else
+  free(p);
+#endif
+}
+
+static void *kin_grow(void *old, int n, int cap, size_t size) {
+  void *arr = kin_alloc(cap * size);
+  // padding lanes are run through the kernels too, keep them finite
+  memset(arr, 0, cap * size);
+  if (old) memcpy(arr, old, n * size);
+  kin_free(old);
+  return arr;
+}
+
+static void kin_reserve(kin *k, int cap) {
+  if (cap <= k->cap) return;
+
+  cap = max(cap, k->cap * 2);
+  void **comps[] = {
+    (void **)&k->px, (void **)&k->py, (void **)&k->pz,
+    (void **)&k->vx, (void **)&k->vy, (void **)&k->vz,
+    (void **)&k->ox, (void **)&k->oy, (void **)&k->oz,
+    (void **)&k->dt, (void **)&k->toi, (void **)&k->step_mask,
+    (void **)&k->on_ground,
+  };
+  for (int i = 0; i < 13; i++) *comps[i] = kin_grow(*comps[i], k->n, cap, 4);
+  k->fast = kin_grow(k->fast, k->n, cap, sizeof(bool));
+  k->dirty = kin_grow(k->dirty, k->n, cap, 1);
+  k->bodies = realloc(k->bodies, cap * sizeof(body *));
+  k->cap = cap;
+}
+
+kin kin_new() {
+  kin k = {.free = arr_new(int)};
+  kin_reserve(&k, 256);
+  return k;
+}
+
+void kin_del(kin *k) {
+  void *comps[] = {
+    k->px, k->py, k->pz, k->vx, k->vy, k->vz, k->ox, k->oy, k->oz,
+    k->dt, k->toi, k->step_mask, k->on_ground, k->fast, k->dirty,
+  };
+  for (int i = 0; i < 15; i++) kin_free(comps[i]);
+  free(k->bodies);
+  arr_del(k->free);
+  *k = (kin){};
+}
+
+int kin_add(kin *k, body *b) {
+  int i;
+  if (!arr_is_empty(k->free)) {
+    i = *arr_last(k->free);
+    arr_len(k->free)--;
+  } else {
+    kin_reserve(k, k->n + kin_width);
+    i = k->n++;
+  }
+
+  k->bodies[i] = b;
+  k->px[i] = b->pos.x, k->py[i] = b->pos.y, k->pz[i] = b->pos.z;
+  k->vx[i] = b->vel.x, k->vy[i] = b->vel.y, k->vz[i] = b->vel.z;
+  k->on_ground[i] = b->on_ground;
+  k->step_mask[i] = -1;
+  k->dirty[i] = 0;
+  return i;
+}
+
+void kin_remove(kin *k, int i) {
+  k->bodies[i] = NULL;
+  k->step_mask[i] = -1;
+  k->dirty[i] = 0;
+  arr_add(&k->free, &i);
+}
+
+void kin_track(kin *k, int i, body *b) {
+  k->bodies[i] = b;
+}
+
+void kin_begin(kin *k) {
+  for (int i = 0; i < k->n; i += kin_width) {
+    *(i8 *)&k->step_mask[i] = (i8){} - 1;
+  }
+
+  k->n_steps = 0;
+}
+
+void kin_move(kin *k, int i, body *b) {
+  k->bodies[i] = b;
+  k->px[i] = b->pos.x, k->py[i] = b->pos.y, k->pz[i] = b->pos.z;
+  k->vx[i] = b->vel.x, k->vy[i] = b->vel.y, k->vz[i] = b->vel.z;
+  k->toi[i] = 1;
+  k->dirty[i] = 2;
+
+  float rad = body_get_rad(b), reach = v3_len(b->vel) * kin_base_steps;
+  int steps = 1;
+  if (rad <= 0) {
+    steps = kin_base_steps;
+  } else {
+    while (steps < kin_max_steps && reach / steps > rad * kin_step_reach)
+      steps *= 2;
+  }
+
+  k->step_mask[i] = steps;
+  k->dt[i] = (float)kin_base_steps / (float)steps;
+  k->fast[i] = rad > 0 && reach / steps > rad * kin_step_reach;
+  k->n_steps = max(k->n_steps, steps);
+}
+
+void kin_plan(kin *k) {
+  for (int s = 0; s < kin_max_steps; s++) k->n_at[s] = 0;
+
+  for (int i = 0; i < k->n; i++) {
+    if (k->step_mask[i] < 0) continue;
+
+    // an entry taking n steps is in every (n_steps / n)-th substep
+    int every = k->n_steps / k->step_mask[i];
+    k->step_mask[i] = every - 1;
+    for (int s = every - 1; s < k->n_steps; s += every) k->n_at[s]++;
+  }
+
+  // entries that don't move keep where they are as where they were, which is
+  // what the last flush of one that just fell asleep wants
+  for (int i = 0; i < k->n; i += kin_width) {
+    i8 moved = *(i8 *)&k->step_mask[i] >= 0;
+    *(f8 *)&k->ox[i] = *(f8 *)&k->px[i];
+    *(f8 *)&k->oy[i] = *(f8 *)&k->py[i];
+    *(f8 *)&k->oz[i] = *(f8 *)&k->pz[i];
+    *(i8 *)&k->on_ground[i] &= ~moved;
+  }
+}
+
+void kin_integrate(kin *k, int s, v3 center, float range) {
+  float fall = body_fall(1.f / kin_base_steps), range_sq = range * range;
+
+  for (int i = 0; i < k->n; i += kin_width) {
+    f8 *px = (f8 *)&k->px[i], *py = (f8 *)&k->py[i], *pz = (f8 *)&k->pz[i];
+    f8 *vx = (f8 *)&k->vx[i], *vy = (f8 *)&k->vy[i], *vz = (f8 *)&k->vz[i];
+    f8 dt = *(f8 *)&k->dt[i], *toi = (f8 *)&k->toi[i];
+
+    f8 dx = *px - center.x, dy = *py - center.y, dz = *pz - center.z;
+    // all ones where the body is in range and steps now
+    i8 on = (dx * dx + dy * dy + dz * dz <= range_sq) &
+            ((((i8){} + s + 1) & *(i8 *)&k->step_mask[i]) == 0);
+
+    f8 move = dt * *toi;
+    *px += (f8)((i8)(*vx * move) & on);
+    *py += (f8)((i8)(*vy * move) & on);
+    *pz += (f8)((i8)(*vz * move) & on);
+    *vy -= (f8)((i8)(fall * dt) & on);
+    *toi = (f8){} + 1.f;
+  }
+}
+
+void kin_load(kin *k, int i) {
+  body *b = k->bodies[i];
+  b->pos = (v3){k->px[i], k->py[i], k->pz[i]};
+  b->vel = (v3){k->vx[i], k->vy[i], k->vz[i]};
+  b->on_ground = k->on_ground[i];
+}
+
+void kin_store(kin *k, int i) {
+  body *b = k->bodies[i];
+  k->px[i] = b->pos.x, k->py[i] = b->pos.y, k->pz[i] = b->pos.z;
+  k->vx[i] = b->vel.x, k->vy[i] = b->vel.y, k->vz[i] = b->vel.z;
+  k->on_ground[i] = b->on_ground;
+}
+
+void kin_flush(kin *k) {
+  for (int i = 0; i < k->n; i++) {
+    if (!k->dirty[i]) continue;
+
+    k->dirty[i]--;
+    kin_load(k, i);
+    k->bodies[i]->prev_pos = (v3){k->ox[i], k->oy[i], k->oz[i]};
+  }
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "body.h"
+
+/*-- the motion of dynamic bodies, kept as an array per component. --*/
+
+// simd_width, without pulling the vector types in everywhere
+#define kin_width 8
+// vel is how far a body moves in 1 / kin_base_steps of a tick
+#define kin_base_steps 4
+#define kin_max_steps 8
+// bodies take enough steps to move at most this much of their radius in one,
+// and sweep against the terrain if kin_max_steps isn't enough
+#define kin_step_reach 0.5f
+
+typedef struct kin {
+  // kin_width aligned and padded, so kernels run over whole vectors
+  float *px, *py, *pz, *vx, *vy, *vz;
+  // where each entry started the tick, its body's prev_pos
+  float *ox, *oy, *oz;
+  // length of each step in base steps, and the fraction of it to move, which
+  // grid_sweep lowers to stop fast bodies at the terrain
+  float *dt, *toi;
+  // steps taken this tick, then turned into a mask by kin_plan: an entry steps
+  // in substep s if (s + 1) & step_mask is 0. -1 for entries not moved this
+  // tick, which never step
+  int *step_mask;
+  // set by the narrowphase, cleared by kin_plan for entries that move
+  int *on_ground;
+  bool *fast;
+  // ticks left to write each entry back to its body. one past its last move,
+  // so a body that fell asleep is left with prev_pos at pos
+  unsigned char *dirty;
+  // the body each entry mirrors
+  body **bodies;
+  // entries given back by kin_remove
+  int *free;
+  int n, cap;
+  // substeps this tick, the most any entry takes
+  int n_steps;
+  // entries stepping in each substep, filled in by kin_plan
+  int n_at[kin_max_steps];
+} kin;
+
+kin kin_new();
+
+void kin_del(kin *k);
+
+// gives b an entry, which it keeps across ticks until kin_remove.
+int kin_add(kin *k, body *b);
+
+void kin_remove(kin *k, int i);
+
+// updates entry i's body address, which moves when objs_tick grows.
+void kin_track(kin *k, int i, body *b);
+
+// starts a tick, no entry moves yet.
+void kin_begin(kin *k);
+
+// copies b's motion into entry i and picks its step count from its speed and
+// size. b's motion is copied in every tick since objs may change it between.
+void kin_move(kin *k, int i, body *b);
+
+// spreads every moved entry's steps evenly over n_steps, once all are moved,
+// and starts them from where they are.
+void kin_plan(kin *k);
+
+[[gnu::always_inline]]
+inline static bool kin_steps_at(kin *k, int i, int s) {
+  return ((s + 1) & k->step_mask[i]) == 0;
+}
+
+// advances the entries stepping in substep s and within range of center.
+void kin_integrate(kin *k, int s, v3 center, float range);
+
+// copies entry i's motion into its body, for the narrowphase.
+void kin_load(kin *k, int i);
+
+// copies entry i's motion back out of its body.
+void kin_store(kin *k, int i);
+
+// copies every entry moved this tick or the last back into its body.
+void kin_flush(kin *k);
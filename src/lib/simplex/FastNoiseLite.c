@@ -1,2 +1,374 @@
 #define FNL_IMPL
-#include "FastNoiseLite.h"
\ No newline at end of file
+#include "FastNoiseLite.h"
+
+// OpenSimplex2S with the analytic derivative, d/dx of a^4 * dot(g, d) with
+// a = 2/3 - |d|^2 is a^4 * g - 8 * a^3 * dot(g, d) * d
+
+static inline void _fnlContrib2D(int seed, int xPrimed, int yPrimed, float xd, float yd, float a, float *value, float *dx, float *dy)
+{
+    int hash = _fnlHash2D(seed, xPrimed, yPrimed);
+    hash ^= hash >> 15;
+    hash &= 127 << 1;
+
+    float xg = GRADIENTS_2D[hash];
+    float yg = GRADIENTS_2D[hash | 1];
+    float dot = xd * xg + yd * yg;
+    float aa = a * a;
+    float a4 = aa * aa;
+    float k = -8 * aa * a * dot;
+
+    *value += a4 * dot;
+    *dx += a4 * xg + k * xd;
+    *dy += a4 * yg + k * yd;
+}
+
+static float _fnlSingleOpenSimplex2S2DGrad(int seed, FNLfloat x, FNLfloat y, float *dx, float *dy)
+{
+    const FNLfloat SQRT3 = (FNLfloat)1.7320508075688772935274463415059;
+    const FNLfloat G2 = (3 - SQRT3) / 6;
+
+    int i = _fnlFastFloor(x);
+    int j = _fnlFastFloor(y);
+    float xi = (float)(x - i);
+    float yi = (float)(y - j);
+
+    i *= PRIME_X;
+    j *= PRIME_Y;
+
+    float t = (xi + yi) * (float)G2;
+    float x0 = xi - t;
+    float y0 = yi - t;
+
+    float value = 0;
+    *dx = 0;
+    *dy = 0;
+
+    float a0 = (2.0f / 3.0f) - x0 * x0 - y0 * y0;
+    _fnlContrib2D(seed, i, j, x0, y0, a0, &value, dx, dy);
+
+    float a1 = (float)(2 * (1 - 2 * G2) * (1 / G2 - 2)) * t + ((float)(-2 * (1 - 2 * G2) * (1 - 2 * G2)) + a0);
+    float x1 = x0 - (float)(1 - 2 * G2);
+    float y1 = y0 - (float)(1 - 2 * G2);
+    _fnlContrib2D(seed, i + PRIME_X, j + PRIME_Y, x1, y1, a1, &value, dx, dy);
+
+    // same lattice point selection as _fnlSingleOpenSimplex2S2D
+    float x2o, y2o, x3o, y3o;
+    int i2, j2, i3, j3;
+    float xmyi = xi - yi;
+    if (t > G2)
+    {
+        if (xi + xmyi > 1)
+        {
+            x2o = (float)(3 * G2 - 2), y2o = (float)(3 * G2 - 1);
+            i2 = i + (PRIME_X << 1), j2 = j + PRIME_Y;
+        }
+        else
+        {
+            x2o = (float)G2, y2o = (float)(G2 - 1);
+            i2 = i, j2 = j + PRIME_Y;
+        }
+
+        if (yi - xmyi > 1)
+        {
+            x3o = (float)(3 * G2 - 1), y3o = (float)(3 * G2 - 2);
+            i3 = i + PRIME_X, j3 = j + (PRIME_Y << 1);
+        }
+        else
+        {
+            x3o = (float)(G2 - 1), y3o = (float)G2;
+            i3 = i + PRIME_X, j3 = j;
+        }
+    }
+    else
+    {
+        if (xi + xmyi < 0)
+        {
+            x2o = (float)(1 - G2), y2o = -(float)G2;
+            i2 = i - PRIME_X, j2 = j;
+        }
+        else
+        {
+            x2o = (float)(G2 - 1), y2o = (float)G2;
+            i2 = i + PRIME_X, j2 = j;
+        }
+
+        if (yi < xmyi)
+        {
+            x3o = -(float)G2, y3o = -(float)(G2 - 1);
+            i3 = i, j3 = j - PRIME_Y;
+        }
+        else
+        {
+            x3o = (float)G2, y3o = (float)(G2 - 1);
+            i3 = i, j3 = j + PRIME_Y;
+        }
+    }
+
+    float x2 = x0 + x2o;
+    float y2 = y0 + y2o;
+    float a2 = (2.0f / 3.0f) - x2 * x2 - y2 * y2;
+    if (a2 > 0)
+    {
+        _fnlContrib2D(seed, i2, j2, x2, y2, a2, &value, dx, dy);
+    }
+
+    float x3 = x0 + x3o;
+    float y3 = y0 + y3o;
+    float a3 = (2.0f / 3.0f) - x3 * x3 - y3 * y3;
+    if (a3 > 0)
+    {
+        _fnlContrib2D(seed, i3, j3, x3, y3, a3, &value, dx, dy);
+    }
+
+    *dx *= 18.24196194486065f;
+    *dy *= 18.24196194486065f;
+    return value * 18.24196194486065f;
+}
+
+// Batched 2D noise, evaluates 8 positions per iteration in AVX2 lanes.
+// The kernel mirrors _fnlSingleOpenSimplex2S2D with the branches replaced by
+// blends, so results match the scalar path. It can also return the analytic
+// derivative alongside the value.
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define FNL_AVX2
+#include <immintrin.h>
+
+__attribute__((target("avx2")))
+static inline void _fnlGradCoordOut2DAvx2(__m256i seed, __m256i xPrimed, __m256i yPrimed, __m256 *xg, __m256 *yg)
+{
+    __m256i hash = _mm256_xor_si256(seed, _mm256_xor_si256(xPrimed, yPrimed));
+    hash = _mm256_mullo_epi32(hash, _mm256_set1_epi32(0x27d4eb2d));
+    hash = _mm256_xor_si256(hash, _mm256_srai_epi32(hash, 15));
+    hash = _mm256_and_si256(hash, _mm256_set1_epi32(127 << 1));
+
+    *xg = _mm256_i32gather_ps(GRADIENTS_2D, hash, 4);
+    *yg = _mm256_i32gather_ps(GRADIENTS_2D, _mm256_or_si256(hash, _mm256_set1_epi32(1)), 4);
+}
+
+// adds a^4 * dot(g, d) to value, and its derivative with respect to d to
+// dx/dy when withGrad is set. lanes outside mask contribute nothing.
+__attribute__((target("avx2"), always_inline))
+static inline void _fnlContrib2DAvx2(__m256i seed, __m256i xPrimed, __m256i yPrimed, __m256 xd, __m256 yd, __m256 a, __m256 mask,
+                                     __m256 *value, __m256 *dx, __m256 *dy, bool withGrad)
+{
+    __m256 xg, yg;
+    _fnlGradCoordOut2DAvx2(seed, xPrimed, yPrimed, &xg, &yg);
+
+    __m256 dot = _mm256_add_ps(_mm256_mul_ps(xd, xg), _mm256_mul_ps(yd, yg));
+    __m256 aa = _mm256_mul_ps(a, a);
+    __m256 a4 = _mm256_mul_ps(aa, aa);
+    *value = _mm256_add_ps(*value, _mm256_and_ps(_mm256_mul_ps(a4, dot), mask));
+
+    if (withGrad)
+    {
+        // d/dd (a^4 * dot) = a^4 * g - 8 * a^3 * dot * d, with a = 2/3 - |d|^2
+        __m256 k = _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(-8), _mm256_mul_ps(aa, a)), dot);
+        *dx = _mm256_add_ps(*dx, _mm256_and_ps(_mm256_add_ps(_mm256_mul_ps(a4, xg), _mm256_mul_ps(k, xd)), mask));
+        *dy = _mm256_add_ps(*dy, _mm256_and_ps(_mm256_add_ps(_mm256_mul_ps(a4, yg), _mm256_mul_ps(k, yd)), mask));
+    }
+}
+
+// picks b where mask is set
+__attribute__((target("avx2")))
+static inline __m256i _fnlBlendi32Avx2(__m256i a, __m256i b, __m256 mask)
+{
+    return _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(a), _mm256_castsi256_ps(b), mask));
+}
+
+// returns the number of positions written, always a multiple of 8
+__attribute__((target("avx2"), always_inline))
+static inline int _fnlSingleOpenSimplex2S2DAvx2(fnl_state *state, const float *xs, const float *ys, float *out, float *outDx, float *outDy, int n,
+                                                bool withGrad)
+{
+    const FNLfloat SQRT3 = (FNLfloat)1.7320508075688772935274463415059;
+    const FNLfloat F2 = 0.5f * (SQRT3 - 1);
+    const FNLfloat G2 = (3 - SQRT3) / 6;
+
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1);
+    const __m256 all = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+    const __m256 freq = _mm256_set1_ps(state->frequency);
+    const __m256 vF2 = _mm256_set1_ps(F2);
+    const __m256 vG2 = _mm256_set1_ps(G2);
+    const __m256 twoThirds = _mm256_set1_ps(2.0f / 3.0f);
+    const __m256 a1Mul = _mm256_set1_ps((float)(2 * (1 - 2 * G2) * (1 / G2 - 2)));
+    const __m256 a1Add = _mm256_set1_ps((float)(-2 * (1 - 2 * G2) * (1 - 2 * G2)));
+    const __m256 off1 = _mm256_set1_ps((float)(1 - 2 * G2));
+    const __m256 scale = _mm256_set1_ps(18.24196194486065f);
+    const __m256i seed = _mm256_set1_epi32(state->seed);
+    const __m256i primeX = _mm256_set1_epi32(PRIME_X);
+    const __m256i primeY = _mm256_set1_epi32(PRIME_Y);
+
+    int k = 0;
+    for (; k + 8 <= n; k += 8)
+    {
+        // _fnlTransformNoiseCoordinate2D
+        __m256 x = _mm256_mul_ps(_mm256_loadu_ps(xs + k), freq);
+        __m256 y = _mm256_mul_ps(_mm256_loadu_ps(ys + k), freq);
+        __m256 s = _mm256_mul_ps(_mm256_add_ps(x, y), vF2);
+        x = _mm256_add_ps(x, s);
+        y = _mm256_add_ps(y, s);
+
+        // _fnlFastFloor, a set compare mask is -1
+        __m256i i = _mm256_add_epi32(_mm256_cvttps_epi32(x), _mm256_castps_si256(_mm256_cmp_ps(x, zero, _CMP_LT_OQ)));
+        __m256i j = _mm256_add_epi32(_mm256_cvttps_epi32(y), _mm256_castps_si256(_mm256_cmp_ps(y, zero, _CMP_LT_OQ)));
+        __m256 xi = _mm256_sub_ps(x, _mm256_cvtepi32_ps(i));
+        __m256 yi = _mm256_sub_ps(y, _mm256_cvtepi32_ps(j));
+
+        i = _mm256_mullo_epi32(i, primeX);
+        j = _mm256_mullo_epi32(j, primeY);
+
+        __m256 t = _mm256_mul_ps(_mm256_add_ps(xi, yi), vG2);
+        __m256 x0 = _mm256_sub_ps(xi, t);
+        __m256 y0 = _mm256_sub_ps(yi, t);
+
+        __m256 value = zero, dx = zero, dy = zero;
+
+        __m256 a0 = _mm256_sub_ps(_mm256_sub_ps(twoThirds, _mm256_mul_ps(x0, x0)), _mm256_mul_ps(y0, y0));
+        _fnlContrib2DAvx2(seed, i, j, x0, y0, a0, all, &value, &dx, &dy, withGrad);
+
+        __m256 a1 = _mm256_add_ps(_mm256_mul_ps(a1Mul, t), _mm256_add_ps(a1Add, a0));
+        __m256 x1 = _mm256_sub_ps(x0, off1);
+        __m256 y1 = _mm256_sub_ps(y0, off1);
+        _fnlContrib2DAvx2(seed, _mm256_add_epi32(i, primeX), _mm256_add_epi32(j, primeY), x1, y1, a1, all, &value, &dx, &dy, withGrad);
+
+        // the nested conditionals pick two more lattice points, as offsets
+        // from x0/y0 and lattice steps in units of the primes
+        __m256 xmyi = _mm256_sub_ps(xi, yi);
+        __m256 up = _mm256_cmp_ps(t, vG2, _CMP_GT_OQ);
+        __m256 xPlus = _mm256_add_ps(xi, xmyi);
+        __m256 yMinus = _mm256_sub_ps(yi, xmyi);
+
+        __m256 c2 = _mm256_blendv_ps(_mm256_cmp_ps(xPlus, zero, _CMP_LT_OQ), _mm256_cmp_ps(xPlus, one, _CMP_GT_OQ), up);
+        __m256 c3 = _mm256_blendv_ps(_mm256_cmp_ps(yi, xmyi, _CMP_LT_OQ), _mm256_cmp_ps(yMinus, one, _CMP_GT_OQ), up);
+
+        __m256 x2o = _mm256_blendv_ps(
+            _mm256_blendv_ps(_mm256_set1_ps((float)(G2 - 1)), _mm256_set1_ps((float)(1 - G2)), c2),
+            _mm256_blendv_ps(_mm256_set1_ps((float)G2), _mm256_set1_ps((float)(3 * G2 - 2)), c2), up);
+        __m256 y2o = _mm256_blendv_ps(
+            _mm256_blendv_ps(_mm256_set1_ps((float)G2), _mm256_set1_ps(-(float)G2), c2),
+            _mm256_blendv_ps(_mm256_set1_ps((float)(G2 - 1)), _mm256_set1_ps((float)(3 * G2 - 1)), c2), up);
+        __m256i i2 = _fnlBlendi32Avx2(
+            _fnlBlendi32Avx2(_mm256_set1_epi32(1), _mm256_set1_epi32(-1), c2),
+            _fnlBlendi32Avx2(_mm256_set1_epi32(0), _mm256_set1_epi32(2), c2), up);
+        __m256i j2 = _fnlBlendi32Avx2(
+            _mm256_set1_epi32(0),
+            _mm256_set1_epi32(1), up);
+
+        __m256 x3o = _mm256_blendv_ps(
+            _mm256_blendv_ps(_mm256_set1_ps((float)G2), _mm256_set1_ps(-(float)G2), c3),
+            _mm256_blendv_ps(_mm256_set1_ps((float)(G2 - 1)), _mm256_set1_ps((float)(3 * G2 - 1)), c3), up);
+        __m256 y3o = _mm256_blendv_ps(
+            _mm256_blendv_ps(_mm256_set1_ps((float)(G2 - 1)), _mm256_set1_ps(-(float)(G2 - 1)), c3),
+            _mm256_blendv_ps(_mm256_set1_ps((float)G2), _mm256_set1_ps((float)(3 * G2 - 2)), c3), up);
+        __m256i i3 = _fnlBlendi32Avx2(
+            _mm256_set1_epi32(0),
+            _mm256_set1_epi32(1), up);
+        __m256i j3 = _fnlBlendi32Avx2(
+            _fnlBlendi32Avx2(_mm256_set1_epi32(1), _mm256_set1_epi32(-1), c3),
+            _fnlBlendi32Avx2(_mm256_set1_epi32(0), _mm256_set1_epi32(2), c3), up);
+
+        __m256 x2 = _mm256_add_ps(x0, x2o);
+        __m256 y2 = _mm256_add_ps(y0, y2o);
+        __m256 a2 = _mm256_sub_ps(_mm256_sub_ps(twoThirds, _mm256_mul_ps(x2, x2)), _mm256_mul_ps(y2, y2));
+        _fnlContrib2DAvx2(seed,
+            _mm256_add_epi32(i, _mm256_mullo_epi32(i2, primeX)),
+            _mm256_add_epi32(j, _mm256_mullo_epi32(j2, primeY)), x2, y2, a2, _mm256_cmp_ps(a2, zero, _CMP_GT_OQ),
+            &value, &dx, &dy, withGrad);
+
+        __m256 x3 = _mm256_add_ps(x0, x3o);
+        __m256 y3 = _mm256_add_ps(y0, y3o);
+        __m256 a3 = _mm256_sub_ps(_mm256_sub_ps(twoThirds, _mm256_mul_ps(x3, x3)), _mm256_mul_ps(y3, y3));
+        _fnlContrib2DAvx2(seed,
+            _mm256_add_epi32(i, _mm256_mullo_epi32(i3, primeX)),
+            _mm256_add_epi32(j, _mm256_mullo_epi32(j3, primeY)), x3, y3, a3, _mm256_cmp_ps(a3, zero, _CMP_GT_OQ),
+            &value, &dx, &dy, withGrad);
+
+        _mm256_storeu_ps(out + k, _mm256_mul_ps(value, scale));
+
+        if (withGrad)
+        {
+            // the skew and unskew cancel out, so d/dx of the input is just
+            // d/dx0 scaled by the frequency
+            __m256 gradScale = _mm256_mul_ps(scale, freq);
+            _mm256_storeu_ps(outDx + k, _mm256_mul_ps(dx, gradScale));
+            _mm256_storeu_ps(outDy + k, _mm256_mul_ps(dy, gradScale));
+        }
+    }
+
+    return k;
+}
+
+__attribute__((target("avx2")))
+static int _fnlSingleOpenSimplex2S2DNAvx2(fnl_state *state, const float *xs, const float *ys, float *out, int n)
+{
+    return _fnlSingleOpenSimplex2S2DAvx2(state, xs, ys, out, NULL, NULL, n, false);
+}
+
+__attribute__((target("avx2")))
+static int _fnlSingleOpenSimplex2S2DGradNAvx2(fnl_state *state, const float *xs, const float *ys, float *out, float *dx, float *dy, int n)
+{
+    return _fnlSingleOpenSimplex2S2DAvx2(state, xs, ys, out, dx, dy, n, true);
+}
+#endif
+
+void fnlGetNoise2DN(fnl_state *state, const FNLfloat *x, const FNLfloat *y, float *out, int n)
+{
+    int done = 0;
+
+#if defined(FNL_AVX2)
+    if (sizeof(FNLfloat) == sizeof(float) &&
+        state->noise_type == FNL_NOISE_OPENSIMPLEX2S &&
+        state->fractal_type == FNL_FRACTAL_NONE &&
+        __builtin_cpu_supports("avx2"))
+    {
+        done = _fnlSingleOpenSimplex2S2DNAvx2(state, (const float *)x, (const float *)y, out, n);
+    }
+#endif
+
+    for (int i = done; i < n; i++)
+    {
+        out[i] = fnlGetNoise2D(state, x[i], y[i]);
+    }
+}
+
+float fnlGetNoise2DGrad(fnl_state *state, FNLfloat x, FNLfloat y, float *dx, float *dy)
+{
+    if (state->noise_type == FNL_NOISE_OPENSIMPLEX2S && state->fractal_type == FNL_FRACTAL_NONE)
+    {
+        // the skew and unskew cancel out, so d/dx of the input is just d/dx0
+        // scaled by the frequency
+        _fnlTransformNoiseCoordinate2D(state, &x, &y);
+        float value = _fnlSingleOpenSimplex2S2DGrad(state->seed, x, y, dx, dy);
+        *dx *= state->frequency;
+        *dy *= state->frequency;
+        return value;
+    }
+
+    // no analytic derivative for the other settings
+    FNLfloat h = 0.001f / state->frequency;
+    *dx = (fnlGetNoise2D(state, x + h, y) - fnlGetNoise2D(state, x - h, y)) / (float)(2 * h);
+    *dy = (fnlGetNoise2D(state, x, y + h) - fnlGetNoise2D(state, x, y - h)) / (float)(2 * h);
+    return fnlGetNoise2D(state, x, y);
+}
+
+void fnlGetNoise2DGradN(fnl_state *state, const FNLfloat *x, const FNLfloat *y, float *out, float *dx, float *dy, int n)
+{
+    int done = 0;
+
+#if defined(FNL_AVX2)
+    if (sizeof(FNLfloat) == sizeof(float) &&
+        state->noise_type == FNL_NOISE_OPENSIMPLEX2S &&
+        state->fractal_type == FNL_FRACTAL_NONE &&
+        __builtin_cpu_supports("avx2"))
+    {
+        done = _fnlSingleOpenSimplex2S2DGradNAvx2(state, (const float *)x, (const float *)y, out, dx, dy, n);
+    }
+#endif
+
+    for (int i = done; i < n; i++)
+    {
+        out[i] = fnlGetNoise2DGrad(state, x[i], y[i], &dx[i], &dy[i]);
+    }
+}
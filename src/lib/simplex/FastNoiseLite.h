@@ -237,6 +237,24 @@ float fnlGetNoise2D(fnl_state *state, FNLfloat x, FNLfloat y);
  */
 float fnlGetNoise3D(fnl_state *state, FNLfloat x, FNLfloat y, FNLfloat z);
 
+/**
+ * 2D noise at n positions using the state settings, out[i] = fnlGetNoise2D(state, x[i], y[i])
+ * @remark Uses 8 wide AVX2 lanes for OpenSimplex2S without fractal when the cpu supports it.
+ */
+void fnlGetNoise2DN(fnl_state *state, const FNLfloat *x, const FNLfloat *y, float *out, int n);
+
+/**
+ * 2D noise and its derivative at given position using the state settings
+ * @returns Noise output bounded between -1 and 1, d/dx and d/dy in dx and dy.
+ * @remark The derivative is analytic for OpenSimplex2S without fractal, other settings use central differences.
+ */
+float fnlGetNoise2DGrad(fnl_state *state, FNLfloat x, FNLfloat y, float *dx, float *dy);
+
+/**
+ * fnlGetNoise2DGrad at n positions, uses AVX2 lanes like fnlGetNoise2DN
+ */
+void fnlGetNoise2DGradN(fnl_state *state, const FNLfloat *x, const FNLfloat *y, float *out, float *dx, float *dy, int n);
+
 /**
  * 2D warps the input position using current domain warp settings.
  * 
@@ -113,6 +113,55 @@ void *map_at_or(map *l, void *key, void *or) {
   return l->vals + l->idx[entry_idx] * l->val_size;
 }
 
+// the idx slot that holds key, SIZE_MAX if key isn't in the map
+static size_t map_slot(map *l, void *key) {
+  uint32_t entry_idx = l->hash(key) % l->cap;
+  while (!idx_is_invalid(l->idx[entry_idx]) &&
+         !l->eq(key, l->keys + l->idx[entry_idx] * l->key_size)) {
+    entry_idx = (entry_idx + 1 == l->cap ? 0: entry_idx + 1);
+  }
+
+  return idx_is_invalid(l->idx[entry_idx]) ? SIZE_MAX : entry_idx;
+}
+
+bool map_remove(map *l, void *key) {
+  size_t hole = map_slot(l, key);
+  if (idx_is_invalid(hole)) return 0;
+
+  size_t removed = l->idx[hole];
+  l->idx[hole] = SIZE_MAX;
+
+  // backward-shift deletion: pull later entries of the probe run into the
+  // hole unless that would move them in front of their home slot
+  for (size_t i = (hole + 1) % l->cap; !idx_is_invalid(l->idx[i]);
+       i = (i + 1) % l->cap) {
+    size_t home = l->hash(l->keys + l->idx[i] * l->key_size) % l->cap;
+    bool movable = hole <= i ? (home <= hole || home > i)
+                             : (home <= hole && home > i);
+    if (!movable) continue;
+
+    l->idx[hole] = l->idx[i];
+    l->idx[i] = SIZE_MAX;
+    hole = i;
+  }
+
+  // keep keys and vals dense by moving the last entry into the gap
+  size_t last = arr_len(l->keys) - 1;
+  if (removed != last) {
+    l->idx[map_slot(l, l->keys + last * l->key_size)] = removed;
+    memcpy(l->keys + removed * l->key_size, l->keys + last * l->key_size,
+           l->key_size);
+    memcpy(l->vals + removed * l->val_size, l->vals + last * l->val_size,
+           l->val_size);
+  }
+
+  arr_len(l->keys)--;
+  arr_len(l->vals)--;
+  l->count--;
+
+  return 1;
+}
+
 bool map_has(map *l, void *key) {
   return map_at(l, key) != NULL;
 }
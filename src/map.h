@@ -25,6 +25,10 @@ void *map_at_or(map *l, void *key, void *or);
 
 bool map_has(map *l, void *key);
 
+// moves the last entry into the removed one's place, so pointers into the
+// map don't survive a removal. returns 0 if key wasn't there.
+bool map_remove(map *l, void *key);
+
 map
 map_new(size_t initial_size, size_t key_size, size_t val_size,
          float load_factor,
@@ -1,10 +1,15 @@
 #pragma once
 
 #include "body.h"
-#include "gl.h"
 
 /*-- an obj that exists in a game world --*/
 
+#ifdef NDEBUG
+#define n_trees 4
+#else
+#define n_trees 1
+#endif
+
 typedef enum obj_type {
   ot_hana,
   ot_test,
@@ -20,9 +25,18 @@ typedef struct tree {
   v3 offset, dir;
   int idx;
   float rot;
-  box3 box;
+  // where the model's bounds are placed
+  v3 base;
 } tree;
 
+// what the player asked for this tick, in terms of the camera's axes.
+// filled in by whoever owns the input, read by hana_tick.
+typedef struct ctrl {
+  float forwards, sideways;
+  bool jump, throw;
+  v3 front, right, up;
+} ctrl;
+
 typedef struct obj {
   union {
     obj_type type;
@@ -31,6 +45,8 @@ typedef struct obj {
   };
 
   int id;
+  // grid handle, registered on the first tick
+  int proxy;
   bool dynamic;
   struct world *world;
   body body;
@@ -40,14 +56,12 @@ obj hana_new();
 
 obj test_new(v3 pos, v3 vel, float rad);
 
-obj tree_new(v3 pos, v3 dir);
-
-void obj_draw(obj *o, draw_src s, cam *c, float d);
+// picks the kind and rotation from r.
+obj tree_new(v3 pos, v3 dir, crng *r);
 
 void obj_tick(obj *o);
 
 v3 obj_get_ipos(obj *o, float d);
 
-box3 obj_get_box(obj *o);
-
-float obj_raycast(obj *e, v3 o, v3 d);
\ No newline at end of file
+// distance along the unit dir d to e's body within l, or -1.
+float obj_raycast(obj *e, v3 o, v3 d, float l);
\ No newline at end of file
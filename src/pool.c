@@ -0,0 +1,66 @@
+#include "pool.h"
+#include "typedefs.h"
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+typedef struct pool_arg {
+  pool *pool;
+  int worker;
+} pool_arg;
+
+static void *pool_worker(void *ap) {
+  pool_arg arg = *(pool_arg *)ap;
+  free(ap);
+  pool *p = arg.pool;
+
+  while (true) {
+    pthread_barrier_wait(&p->start);
+    p->fn(p->ctx, arg.worker);
+    pthread_barrier_wait(&p->done);
+  }
+
+  return NULL;
+}
+
+static long pool_n_cores() {
+#ifdef _WIN32
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return (long)info.dwNumberOfProcessors;
+#else
+  return sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+}
+
+pool *pool_new() {
+  long n_cores = pool_n_cores();
+  pool *p = _new_((pool){
+    .n_workers = (int)max(min(n_cores, pool_max_workers), 1L),
+  });
+
+  pthread_barrier_init(&p->start, NULL, p->n_workers);
+  pthread_barrier_init(&p->done, NULL, p->n_workers);
+
+  for (int i = 1; i < p->n_workers; i++) {
+    pthread_create(&p->workers[i], NULL, pool_worker,
+                   _new_((pool_arg){p, i}));
+  }
+
+  return p;
+}
+
+void pool_run(pool *p, pool_fn fn, void *ctx) {
+  if (p->n_workers == 1) {
+    fn(ctx, 0);
+    return;
+  }
+
+  p->fn = fn;
+  p->ctx = ctx;
+  pthread_barrier_wait(&p->start);
+  fn(ctx, 0);
+  pthread_barrier_wait(&p->done);
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <pthread.h>
+
+/*-- a fixed set of threads that run one job together. --*/
+
+#define pool_max_workers 16
+
+typedef void (*pool_fn)(void *ctx, int worker);
+
+typedef struct pool {
+  pthread_t workers[pool_max_workers];
+  // the thread calling pool_run counts as worker 0
+  int n_workers;
+  pthread_barrier_t start, done;
+
+  pool_fn fn;
+  void *ctx;
+} pool;
+
+// one worker per core, up to pool_max_workers.
+pool *pool_new();
+
+// runs fn on every worker and returns once all of them are done.
+void pool_run(pool *p, pool_fn fn, void *ctx);
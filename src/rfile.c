@@ -0,0 +1,219 @@
+#include "rfile.h"
+#include <errno.h>
+#include <stddef.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#include <direct.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+static char const rfile_magic[4] = {'w', 'i', 'p', 'r'};
+
+static void rfile_unmap(rfile *r) {
+  if (!r->view) return;
+
+#ifdef _WIN32
+  UnmapViewOfFile(r->view);
+  CloseHandle(r->mapping);
+#else
+  munmap(r->view, r->view_len);
+#endif
+
+  r->view = NULL;
+  r->view_len = 0;
+}
+
+static void rfile_map(rfile *r) {
+  rfile_unmap(r);
+
+  fflush(r->f);
+  fseek(r->f, 0, SEEK_END);
+  size_t len = (size_t)ftell(r->f);
+
+#ifdef _WIN32
+  HANDLE file = (HANDLE)_get_osfhandle(_fileno(r->f));
+  r->mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  if (!r->mapping) throwf("rfile_map: failed to map region file!");
+  r->view = MapViewOfFile(r->mapping, FILE_MAP_READ, 0, 0, len);
+#else
+  r->view = mmap(NULL, len, PROT_READ, MAP_SHARED, fileno(r->f), 0);
+  if (r->view == MAP_FAILED) r->view = NULL;
+#endif
+
+  if (!r->view) throwf("rfile_map: failed to map region file!");
+  r->view_len = len;
+}
+
+static rfile_head rfile_head_new() {
+  rfile_head h = {
+    .version = rfile_version,
+    .grid_len = chunk_len,
+    .rec_size = sizeof(rfile_rec),
+  };
+
+  memcpy(h.magic, rfile_magic, sizeof(h.magic));
+  return h;
+}
+
+static bool rfile_head_ok(rfile *r) {
+  if (r->view_len < sizeof(rfile_head)) return 0;
+
+  rfile_head *h = (rfile_head *)r->view;
+  return !memcmp(h->magic, rfile_magic, sizeof(h->magic)) &&
+         h->version == rfile_version && h->grid_len == chunk_len &&
+         h->rec_size == sizeof(rfile_rec);
+}
+
+static rfile rfile_new(char const *path) {
+  rfile r = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .f = fopen(path, "r+b"),
+    .view_lock = PTHREAD_RWLOCK_INITIALIZER,
+  };
+
+  if (r.f) {
+    rfile_map(&r);
+    if (rfile_head_ok(&r)) return r;
+
+    // written by an older build, start it over
+    rfile_unmap(&r);
+    fclose(r.f);
+    r.f = NULL;
+  }
+
+  r.f = fopen(path, "w+b");
+  if (!r.f) throwf("rfile_new: failed to create %s!", path);
+
+  rfile_head h = rfile_head_new();
+  fwrite(&h, sizeof(h), 1, r.f);
+  rfile_map(&r);
+
+  return r;
+}
+
+static int floor_div(int a, int b) {
+  return a / b - (a % b < 0);
+}
+
+static rfile *rfile_store_get(rfile_store *s, iv2 pos, int *idx) {
+  iv2 rpos = {floor_div(pos.x, rfile_n), floor_div(pos.y, rfile_n)};
+  *idx = (pos.x - rpos.x * rfile_n) + (pos.y - rpos.y * rfile_n) * rfile_n;
+
+  pthread_mutex_lock(&s->lock);
+
+  // files are boxed so they stay put when the map grows
+  rfile **at = map_at(&s->files, &rpos), *r;
+  if (at) {
+    r = *at;
+  } else {
+    char path[256];
+    snprintf(path, sizeof(path), "%s/r.%d.%d.bin", s->dir, rpos.x, rpos.y);
+    r = _new_(rfile_new(path));
+    map_add(&s->files, &rpos, &r);
+  }
+
+  pthread_mutex_unlock(&s->lock);
+  return r;
+}
+
+// off is past the end of the view, so it was saved after the last remap.
+static void rfile_remap(rfile *r, u32 off) {
+  pthread_mutex_lock(&r->lock);
+  pthread_rwlock_wrlock(&r->view_lock);
+
+  // another reader may have got here first
+  if (off + sizeof(rfile_rec) > r->view_len) rfile_map(r);
+
+  pthread_rwlock_unlock(&r->view_lock);
+  pthread_mutex_unlock(&r->lock);
+}
+
+rfile_store *rfile_store_new(char const *dir) {
+#ifdef _WIN32
+  int err = _mkdir(dir);
+#else
+  int err = mkdir(dir, 0755);
+#endif
+  if (err && errno != EEXIST) {
+    throwf("rfile_store_new: failed to create %s!", dir);
+  }
+
+  return _new_((rfile_store){
+    .dir = dir,
+    .files = map_new(16, sizeof(iv2), sizeof(rfile *), 0.5f, iv2_peq, iv2_hash),
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+  });
+}
+
+bool rfile_store_load(rfile_store *s, iv2 pos, chunk *out) {
+  int idx;
+  rfile *r = rfile_store_get(s, pos, &idx);
+
+  pthread_rwlock_rdlock(&r->view_lock);
+  u32 off = ((rfile_head *)r->view)->offs[idx];
+
+  if (off && off + sizeof(rfile_rec) > r->view_len) {
+    pthread_rwlock_unlock(&r->view_lock);
+    rfile_remap(r, off);
+    pthread_rwlock_rdlock(&r->view_lock);
+  }
+
+  // the copy only needs the view to stay mapped, not the file lock
+  bool found = off && off + sizeof(rfile_rec) <= r->view_len;
+  if (found) {
+    rfile_rec *rec = (rfile_rec *)(r->view + off);
+    *out = (chunk){
+      .id = rec->id,
+      .pos = pos,
+      .has_tree = rec->has_tree,
+      .tree_pos = rec->tree_pos,
+      .tree_dir = rec->tree_dir,
+    };
+
+    memcpy(out->data, rec->data, sizeof(out->data));
+  }
+
+  pthread_rwlock_unlock(&r->view_lock);
+
+  if (found) chunk_build_body(out);
+  return found;
+}
+
+void rfile_store_save(rfile_store *s, chunk *c) {
+  int idx;
+  rfile *r = rfile_store_get(s, c->pos, &idx);
+
+  rfile_rec rec = {
+    .id = c->id,
+    .has_tree = c->has_tree,
+    .tree_pos = c->tree_pos,
+    .tree_dir = c->tree_dir,
+  };
+
+  memcpy(rec.data, c->data, sizeof(rec.data));
+
+  pthread_mutex_lock(&r->lock);
+
+  pthread_rwlock_rdlock(&r->view_lock);
+  bool saved = ((rfile_head *)r->view)->offs[idx];
+  pthread_rwlock_unlock(&r->view_lock);
+  if (saved) goto done;
+
+  fseek(r->f, 0, SEEK_END);
+  u32 off = (u32)ftell(r->f);
+  fwrite(&rec, sizeof(rec), 1, r->f);
+
+  // the record has to land before the table points at it
+  fflush(r->f);
+  fseek(r->f, (long)(offsetof(rfile_head, offs) + idx * sizeof(u32)),
+        SEEK_SET);
+  fwrite(&off, sizeof(off), 1, r->f);
+  fflush(r->f);
+
+done:
+  pthread_mutex_unlock(&r->lock);
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stdio.h>
+#include <pthread.h>
+#include "typedefs.h"
+#include "map.h"
+#include "chunk.h"
+
+/*-- on-disk cache of generated chunks, grouped into region files. --*/
+
+// a region file holds rfile_n x rfile_n chunks
+#define rfile_n 32
+// bump whenever the layout of rfile_head or rfile_rec changes
+#define rfile_version 2
+
+typedef struct rfile_head {
+  char magic[4];
+  u32 version, grid_len, rec_size;
+
+  // byte offset of each chunk's record, 0 if it was never saved
+  u32 offs[rfile_n * rfile_n];
+} rfile_head;
+
+typedef struct rfile_rec {
+  int id, has_tree;
+  v3 tree_pos, tree_dir;
+  ch_vtx data[chunk_len * chunk_len];
+} rfile_rec;
+
+typedef struct rfile {
+  // held across writes to f and remaps of the view
+  pthread_mutex_t lock;
+  FILE *f;
+
+  // read-only view of the whole file, remapped when records are appended.
+  // readers hold view_lock shared while they copy out of it.
+  pthread_rwlock_t view_lock;
+  u8 *view;
+  size_t view_len;
+  void *mapping;
+} rfile;
+
+typedef struct rfile_store {
+  char const *dir;
+
+  // iv2 -> rfile *, keyed by region position. lock only guards the map.
+  map files;
+  pthread_mutex_t lock;
+} rfile_store;
+
+rfile_store *rfile_store_new(char const *dir);
+
+// fills out from the cache, returns 0 if pos was never saved.
+bool rfile_store_load(rfile_store *s, iv2 pos, chunk *out);
+
+void rfile_store_save(rfile_store *s, chunk *c);
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <immintrin.h>
+
+/*-- 8 wide float and int vectors, as one avx2 register each. --*/
+
+#define simd_width 8
+
+typedef float f8 __attribute__((vector_size(simd_width * sizeof(float))));
+// comparisons of f8s give all ones where true
+typedef int i8 __attribute__((vector_size(simd_width * sizeof(int))));
+
+[[gnu::always_inline]]
+inline static f8 f8_set(float f) {
+  return (f8){f, f, f, f, f, f, f, f};
+}
+
+[[gnu::always_inline]]
+inline static f8 f8_abs(f8 f) {
+  return (f8)((i8)f & 0x7fffffff);
+}
+
+// a where mask is set, b elsewhere
+[[gnu::always_inline]]
+inline static f8 f8_select(i8 mask, f8 a, f8 b) {
+  return (f8)(((i8)a & mask) | ((i8)b & ~mask));
+}
+
+[[gnu::always_inline]]
+inline static f8 f8_clamp01(f8 f) {
+  // like clamp, nans come out as 0
+  f = f8_select(f > 0, f, f8_set(0));
+  return f8_select(f < 1, f, f8_set(1));
+}
+
+[[gnu::always_inline]]
+inline static f8 f8_sqrt(f8 f) {
+  return (f8)_mm256_sqrt_ps((__m256)f);
+}
@@ -0,0 +1,78 @@
+#include "ticker.h"
+#include "typedefs.h"
+#include <errno.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <windows.h>
+// since windows 10 1803, older headers don't define it
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x2
+#endif
+#endif
+
+int64_t ticker_now() {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (int64_t)t.tv_sec * ticker_ns_per_s + t.tv_nsec;
+}
+
+ticker ticker_new(int rate) {
+  ticker t = {
+    .period = ticker_ns_per_s / max(rate, 1),
+    .next = ticker_now(),
+    .spin = ticker_spin_ns,
+  };
+
+#ifdef _WIN32
+  // winpthreads' clock_nanosleep only wakes on the system tick, ~15.6 ms
+  t.timer = CreateWaitableTimerExW(NULL, NULL,
+                                   CREATE_WAITABLE_TIMER_HIGH_RESOLUTION,
+                                   TIMER_ALL_ACCESS);
+  if (!t.timer) {
+    // older than 1803. a 1 ms system tick is the best that's left
+    timeBeginPeriod(1);
+    t.spin = ticker_coarse_spin_ns;
+  }
+#endif
+
+  return t;
+}
+
+// sleeps until about wake, in ticker_now's ns.
+static void ticker_sleep(ticker *t, int64_t wake) {
+#ifdef _WIN32
+  if (t->timer) {
+    // negative is relative, in 100 ns units
+    LARGE_INTEGER due = {.QuadPart = -(wake - ticker_now()) / 100};
+    if (due.QuadPart < 0 && SetWaitableTimer(t->timer, &due, 0, NULL, NULL, 0)) {
+      WaitForSingleObject(t->timer, INFINITE);
+    }
+    return;
+  }
+#endif
+
+  struct timespec ts = {
+    .tv_sec = wake / ticker_ns_per_s,
+    .tv_nsec = wake % ticker_ns_per_s,
+  };
+  // signals cut sleeps short, the deadline is absolute so just go again
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR);
+}
+
+int ticker_wait(ticker *t) {
+  int64_t now = ticker_now(), wake = t->next - t->spin;
+  if (now < wake) ticker_sleep(t, wake);
+
+  while ((now = ticker_now()) < t->next);
+
+  int n = (int)((now - t->next) / t->period) + 1;
+  if (n > ticker_max_behind) {
+    // a stall, like a debugger break. catching all of it up would stall again
+    t->next = now + t->period;
+    return ticker_max_behind;
+  }
+
+  t->next += n * t->period;
+  return n;
+}
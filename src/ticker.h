@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdint.h>
+
+/*-- fixed rate deadlines on the monotonic clock. --*/
+
+#define ticker_ns_per_s 1000000000ll
+// the last stretch before a deadline is spun on rather than slept through,
+// since sleeps overshoot by up to a scheduler quantum
+#define ticker_spin_ns 500000ll
+// where sleeps only wake on a 1 ms system tick
+#define ticker_coarse_spin_ns 2000000ll
+// ticks this far behind are dropped instead of caught up on
+#define ticker_max_behind 10
+
+typedef struct ticker {
+  // ns between ticks
+  int64_t period;
+  // when the next tick is due, in ticker_now's ns
+  int64_t next;
+  // how long before next ticker_wait stops sleeping and spins
+  int64_t spin;
+  // a high resolution waitable timer on windows, NULL elsewhere
+  void *timer;
+} ticker;
+
+// ns on CLOCK_MONOTONIC, which never jumps and doesn't lose precision.
+int64_t ticker_now();
+
+// rate ticks a second, the first one due right away.
+ticker ticker_new(int rate);
+
+// sleeps until the next tick is due and returns how many are, at most
+// ticker_max_behind.
+int ticker_wait(ticker *t);
@@ -211,6 +211,20 @@ inline static iv2 iv2_mul(iv2 lhs, int scalar) {
   return (iv2){lhs.x * scalar, lhs.y * scalar};
 }
 
+typedef union iv3 {
+  struct {
+    int x, y, z;
+  };
+
+  int v[3];
+} iv3;
+
+[[gnu::always_inline]]
+
+inline static bool iv3_eq(iv3 lhs, iv3 rhs) {
+  return lhs.x == rhs.x && lhs.y == rhs.y && lhs.z == rhs.z;
+}
+
 [[gnu::always_inline]]
 
 inline static iv2 iv2_div(iv2 lhs, int scalar) {
@@ -661,6 +675,14 @@ static bool iv2_peq(void *_lhs, void *_rhs) {
   return memcmp(_lhs, _rhs, sizeof(iv2)) == 0;
 }
 
+static uint32_t iv3_hash(void *key) {
+  return hash_murmur3(key, sizeof(iv3));
+}
+
+static bool iv3_peq(void *_lhs, void *_rhs) {
+  return memcmp(_lhs, _rhs, sizeof(iv3)) == 0;
+}
+
 static int idx_wrap(int size, int index) {
   if (index < 0) index += size;
   index %= size;
@@ -697,6 +719,51 @@ inline int rndi(int min, int max) {
   return (int)(mi + rand() % (ma - mi));
 }
 
+// counter based rng. the nth number only depends on (seed, pos, stream, n),
+// so results don't care which thread asks or in what order.
+typedef struct crng {
+  uint64_t key;
+  uint32_t ctr;
+} crng;
+
+[[gnu::always_inline]]
+inline static uint64_t crng_mix(uint64_t x) {
+  // splitmix64 finalizer
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ull;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebull;
+  x ^= x >> 31;
+  return x;
+}
+
+[[gnu::always_inline]]
+inline static crng crng_new(uint32_t seed, iv2 pos, uint32_t stream) {
+  uint64_t p = (uint64_t)(uint32_t)pos.x << 32 | (uint32_t)pos.y;
+  uint64_t k = crng_mix(seed ^ crng_mix(p + 0x9e3779b97f4a7c15ull));
+  return (crng){.key = crng_mix(k ^ (uint64_t)stream << 32)};
+}
+
+[[gnu::always_inline]]
+inline static uint32_t crng_u32(crng *r) {
+  return (uint32_t)(crng_mix(r->key + r->ctr++ * 0x9e3779b97f4a7c15ull) >> 32);
+}
+
+// [min, max)
+[[gnu::always_inline]]
+inline static float crng_f(crng *r, float min, float max) {
+  float d = (float)(crng_u32(r) >> 8) * 0x1p-24f;
+  return min + d * (max - min);
+}
+
+// [min, max)
+[[gnu::always_inline]]
+inline static int crng_i(crng *r, int min, int max) {
+  int64_t mi = min, ma = max;
+  if (mi == ma) return (int)mi;
+  return (int)(mi + (int64_t)((uint64_t)crng_u32(r) * (uint64_t)(ma - mi) >> 32));
+}
+
 [[gnu::always_inline]]
 inline static v4 v4q_slerp(v4 from, v4 to, float t) {
   v4 q1, q2;
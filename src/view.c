@@ -0,0 +1,446 @@
+#include "view.h"
+#include "app.h"
+#include "pal.h"
+#include <stdatomic.h>
+
+static struct {
+  mod *hana;
+  imod *ball, *cyl, *trunks[n_trees * 2], *leaves[n_trees * 2];
+  // objs drawn as whole mods rather than instances, held back until
+  // view_draw like the imods are until imod_draw
+  obj_snap **mods;
+  int init;
+} lazy;
+
+static void hana_draw(obj_snap *o, draw_src s, cam *c, float d);
+
+view *view_new() {
+  buf slots = buf_new(GL_SHADER_STORAGE_BUFFER),
+    ib = buf_new(GL_ELEMENT_ARRAY_BUFFER);
+
+  auto v = _new_((view){
+    .slots = slots,
+    .ib = ib,
+    // no attributes, only the lod index ranges
+    .va = vao_new(&slots, &ib, 0, NULL),
+    .slot_data = malloc(view_n_slots * sizeof(ter_slot)),
+    .slot_draws = arr_new(int),
+    .slot_lods = arr_new(int),
+    .last_center = (iv2){INT_MAX, INT_MAX},
+    .back = 0,
+    .mid = 1,
+    .front = 2,
+  });
+
+  for (int i = 0; i < view_n_snaps; i++) {
+    v->snaps[i] = (view_snap){
+      .objs = arr_new(obj_snap),
+      .slot_writes = arr_new(int),
+      .slot_data = arr_new(ter_slot),
+      .slot_draws = arr_new(int),
+      .slot_lods = arr_new(int),
+    };
+  }
+
+  for (int i = 0; i < view_n_slots; i++) {
+    v->slot_pos[i] = (iv2){INT_MAX, INT_MAX};
+  }
+
+  // every slot shares one index range per lod level. the base vertex makes
+  // gl_VertexID slot * chunk_len^2 + grid index.
+  buf_data_n(&v->slots, GL_DYNAMIC_DRAW, sizeof(ter_slot), view_n_slots,
+             NULL);
+
+  int *inds = arr_new(int);
+  for (int l = 0; l < view_n_lods; l++) {
+    int step = 1 << l, n = chunk_qty / step + 1;
+    int *lvl = quad_indices(n, n);
+
+    v->lod_first[l] = arr_len(inds);
+    v->lod_count[l] = arr_len(lvl);
+    for (int *k = lvl, *end = arr_end(lvl); k != end; k++) {
+      arr_add(&inds, &(int){(*k / n) * step * chunk_len + (*k % n) * step});
+    }
+
+    arr_del(lvl);
+  }
+
+  buf_data_n(&v->ib, GL_STATIC_DRAW, sizeof(int), arr_len(inds), inds);
+  arr_del(inds);
+
+  return v;
+}
+
+static int view_slot(iv2 chunk_pos) {
+  int x = (chunk_pos.x % world_sp_size + world_sp_size) % world_sp_size,
+    z = (chunk_pos.y % world_sp_size + world_sp_size) % world_sp_size;
+  return x * world_sp_size + z;
+}
+
+// lod level of the chunk at offset i, j from the camera's chunk. distances
+// are taken from the camera's 3x3 neighbourhood so the level is never too
+// coarse for where the render camera actually is until the next recache.
+static int view_lod_of(int i, int j) {
+  float dx = (float)max(abs(i) - 2, 0) * chunk_sizef,
+    dz = (float)max(abs(j) - 2, 0) * chunk_sizef;
+  float d = sqrtf(dx * dx + dz * dz);
+
+  int l = 0;
+  while (l < view_n_lods - 1 && d >= view_lod_range * (float)(1 << l)) l++;
+  return l;
+}
+
+static u32 pack_norm(v3 n) {
+  float l1 = fabsf(n.x) + fabsf(n.y) + fabsf(n.z);
+  int16_t x = (int16_t)lrintf(n.x / l1 * 32767.f),
+    z = (int16_t)lrintf(n.z / l1 * 32767.f);
+  return (u32)(uint16_t)x | (u32)(uint16_t)z << 16;
+}
+
+static void pack_slot(chunk const *c, ter_slot *out) {
+  out->pos = c->pos;
+  out->id = c->id;
+  out->pad = 0;
+
+  for (int i = 0; i < chunk_len * chunk_len; i++) {
+    out->h[i] = c->data[i].pos.y;
+    out->norm[i] = pack_norm(c->data[i].norm);
+  }
+}
+
+// rebuilds the draw lists if the world's chunks or center changed, packing
+// the slots that have to be rewritten for the snapshot seq.
+static void view_cache(view *v, world *w, iv2 center, unsigned seq) {
+  if (iv2_eq(v->last_center, center) && v->last_version == w->chunks_version) {
+    return;
+  }
+
+  // only chunks entering the ring get written, the rest stay in their slots
+  arr_clear(v->slot_draws);
+  arr_clear(v->slot_lods);
+
+  for (int i = -world_draw_dist; i <= world_draw_dist; i++) {
+    for (int j = -world_draw_dist; j <= world_draw_dist; j++) {
+      float dist = sqrtf(i * i + j * j);
+      if (dist > world_draw_dist + 1) continue;
+
+      iv2 chunk_pos = {center.x + i, center.y + j};
+
+      chunk *c = map_at(&w->chunks, &chunk_pos);
+      if (!c) continue;
+
+      int slot = view_slot(chunk_pos);
+      if (!iv2_eq(v->slot_pos[slot], chunk_pos)) {
+        v->slot_pos[slot] = chunk_pos;
+        v->slot_seq[slot] = seq;
+        pack_slot(c, &v->slot_data[slot]);
+      }
+
+      arr_add(&v->slot_draws, &(int){slot * chunk_len * chunk_len});
+      arr_add(&v->slot_lods, &(int){view_lod_of(i, j)});
+    }
+  }
+
+  v->last_center = center;
+  v->last_version = w->chunks_version;
+}
+
+void view_publish(view *v, world *w, iv2 center) {
+  view_snap *s = &v->snaps[v->back];
+  s->seq = ++v->seq;
+
+  // a slot keeps being written until the renderer has taken a snapshot
+  // carrying it, so skipped snapshots don't lose writes. only its latest
+  // data matters
+  view_cache(v, w, center, s->seq);
+  unsigned taken = atomic_load(&v->taken);
+  arr_clear(s->slot_writes);
+  arr_clear(s->slot_data);
+  for (int i = 0; i < view_n_slots; i++) {
+    if (v->slot_seq[i] <= taken) continue;
+
+    arr_add(&s->slot_writes, &i);
+    arr_add(&s->slot_data, &v->slot_data[i]);
+  }
+  arr_copy(&s->slot_draws, v->slot_draws);
+  arr_copy(&s->slot_lods, v->slot_lods);
+
+  arr_clear(s->objs);
+  for (obj *o = w->objs_tick, *end = arr_end(w->objs_tick); o != end; o++) {
+    obj_snap os = {
+      .id = o->id,
+      .pos = o->body.pos,
+      .prev_pos = o->body.prev_pos,
+    };
+    if (o->type == ot_tree) {
+      os.tree = o->tree;
+    } else {
+      os.type = o->type;
+    }
+    if (o->body.type == bt_cap) {
+      os.cap = o->body.cap;
+    } else if (o->body.type == bt_ball) {
+      os.ball = o->body.ball;
+    }
+    arr_add(&s->objs, &os);
+  }
+  s->time = ticker_now();
+
+  int old = atomic_exchange(&v->mid, v->back | view_fresh);
+  v->back = old & ~view_fresh;
+}
+
+view_snap *view_take(view *v) {
+  if (!(atomic_load(&v->mid) & view_fresh)) return &v->snaps[v->front];
+
+  v->front = atomic_exchange(&v->mid, v->front) & ~view_fresh;
+  view_snap *s = &v->snaps[v->front];
+  for (size_t i = 0; i < arr_len(s->slot_writes); i++) {
+    gl_named_buffer_sub_data(v->slots.id, s->slot_writes[i] * sizeof(ter_slot),
+                             sizeof(ter_slot), &s->slot_data[i]);
+  }
+  atomic_store(&v->taken, s->seq);
+
+  return s;
+}
+
+void view_draw(view *v, view_snap *snap, draw_src s, cam *c, float d) {
+  shdr *sh = ch_get_sh(s, c);
+  shdr_3f(sh, "u_lod_eye", c->pos);
+  shdr_1f(sh, "u_lod_range", view_lod_range);
+  shdr_1f(sh, "u_lod_morph", view_lod_morph);
+
+  static GLsizei counts[view_n_slots];
+  static void const *offs[view_n_slots];
+  int n_draws = arr_len(snap->slot_draws);
+  size_t n_inds = 0;
+  for (int i = 0; i < n_draws; i++) {
+    int l = snap->slot_lods[i];
+    counts[i] = v->lod_count[l];
+    offs[i] = (void const *)(v->lod_first[l] * sizeof(int));
+    n_inds += counts[i];
+  }
+
+  vao_bind(&v->va);
+  gl_bind_buffer_base(GL_SHADER_STORAGE_BUFFER, 0, v->slots.id);
+  gl_multi_draw_elements_base_vertex(GL_TRIANGLES, counts, GL_UNSIGNED_INT,
+                                     offs, n_draws, snap->slot_draws);
+  $.n_tris += n_inds / 3;
+
+  for (obj_snap **o = lazy.mods, **end = arr_end(lazy.mods); o != end; o++) {
+    hana_draw(*o, s, c, d);
+  }
+  arr_clear(lazy.mods);
+}
+
+void view_cull(view_snap *snap, draw_src s, cam *c, float d) {
+  $.n_drawn = $.n_close = 0;
+
+  for (obj_snap *o = snap->objs, *end = arr_end(snap->objs); o != end; o++) {
+    if (v3_dist(o->pos, c->pos) > (world_draw_dist + 1) * chunk_size) {
+      continue;
+    }
+
+    $.n_close++;
+
+    if (!cam_test_box(&$.cam, obj_get_box(o), s)) {
+      continue;
+    }
+
+    $.n_drawn++;
+
+    obj_draw(o, s, c, d);
+  }
+}
+
+shdr *ch_get_sh(draw_src s, cam *c) {
+  static shdr *cam = NULL;
+  static shdr *shade = NULL;
+  static mtl m = {
+    .light = 6,
+    .dark = 0,
+    .light_model = {0, 0.8f, 0},
+    .alpha = 1.f
+  };
+
+  if (!cam) {
+    cam = _new_(shdr_new(2,
+                         (shdr_s[]){
+                           {GL_VERTEX_SHADER,   "res/chunk.vsh"},
+                           {GL_FRAGMENT_SHADER, "res/mod_light.fsh"},
+                         }));
+
+    shade = _new_(shdr_new(2,
+                           (shdr_s[]){
+                             {GL_VERTEX_SHADER,   "res/chunk_depth.vsh"},
+                             {GL_FRAGMENT_SHADER, "res/mod_depth.fsh"},
+                           }));
+  }
+
+  shdr *cur = s == ds_cam ? cam : shade;
+
+  shdr_m4f(cur, "u_model", m4_ident);
+  shdr_3f(cur, "u_eye", cam_get_eye(c));
+  shdr_1f(cur, "u_time", app_secs(wind_period));
+  shdr_3f(cur, "u_light_model", m.light_model);
+  shdr_3f(cur, "u_light", dreamy_haze[m.light]);
+  shdr_3f(cur, "u_dark", dreamy_haze[m.dark]);
+  shdr_1f(cur, "u_trans", m.transmission);
+  shdr_1f(cur, "u_shine", m.shine);
+  shdr_1f(cur, "u_wind", m.wind);
+  shdr_1f(cur, "u_alpha", m.alpha);
+  shdr_bind(cur);
+
+  return cur;
+}
+
+static void lazy_init() {
+  if (lazy.init) return;
+
+#ifdef NDEBUG
+  static char const *trunk_paths[n_trees * 2] = {
+    "res/bush2_trunk.glb",
+    "res/bush3_trunk.glb",
+    "res/tree1_trunk.glb",
+    "res/tree2_trunk.glb",
+    "res/bush2_trunk_dec.glb",
+    "res/bush3_trunk_dec.glb",
+    "res/tree1_trunk_dec.glb",
+    "res/tree2_trunk_dec.glb",
+  };
+
+  static char const *leaf_paths[n_trees * 2] = {
+    "res/bush2_leaves.glb",
+    "res/bush3_leaves.glb",
+    "res/tree1_leaves.glb",
+    "res/tree2_leaves.glb",
+    "res/bush2_leaves_dec.glb",
+    "res/bush3_leaves_dec.glb",
+    "res/tree1_leaves_dec.glb",
+    "res/tree2_leaves_dec.glb",
+  };
+
+  static char const *mtl_paths[n_trees] = {
+    "res/bush2.glb",
+    "res/bush3.glb",
+    "res/tree1.glb",
+    "res/tree2.glb",
+  };
+#else
+  static char const *trunk_paths[n_trees * 2] = {
+    "res/bush2_trunk.glb",
+    "res/bush2_trunk_dec.glb",
+  };
+
+  static char const *leaf_paths[n_trees * 2] = {
+    "res/bush2_leaves.glb",
+    "res/bush2_leaves_dec.glb",
+  };
+
+  static char const *mtl_paths[n_trees] = {
+    "res/bush2.glb",
+  };
+#endif
+
+  for (int i = 0; i < n_trees; i++) {
+    lazy.leaves[i] = imod_new(
+      mod_new_indirect_mtl(leaf_paths[i], mtl_paths[i]));
+    lazy.leaves[i + n_trees] = imod_new(
+      mod_new_indirect_mtl(leaf_paths[i + n_trees], mtl_paths[i]));
+    lazy.trunks[i] = imod_new(
+      mod_new_indirect_mtl(trunk_paths[i], mtl_paths[i]));
+    lazy.trunks[i + n_trees] = imod_new(
+      mod_new_indirect_mtl(trunk_paths[i + n_trees], mtl_paths[i]));
+  }
+
+#ifdef NDEBUG
+  lazy.hana = _new_(mod_new("res/hana.glb"));
+#endif
+
+  lazy.mods = arr_new(obj_snap *);
+  lazy.ball = imod_new(mod_new("res/ball.glb"));
+  lazy.cyl = imod_new(mod_new("res/cylinder.glb"));
+
+  lazy.init = 1;
+}
+
+static void hana_draw(obj_snap *o, draw_src s, cam *c, float d) {
+  cap cap = o->cap;
+  v3 base = v3_sub(obj_snap_ipos(o, d), v3_mul(cap.norm, cap.ext + cap.rad));
+  mod_draw(lazy.hana, s, c, m4_mul(m4_trans(0, 0, 0.215f),
+                                   m4_mul(m4_rot_y(
+                                            -rad($.cam.yaw) + M_PIF / 2.f),
+                                          m4_trans_v(base))), o->id);
+}
+
+void obj_draw(obj_snap *o, draw_src s, cam *c, float d) {
+  lazy_init();
+
+  switch (o->type) {
+    case ot_hana: {
+#ifdef NDEBUG
+      arr_add(&lazy.mods, &o);
+#else
+      float r = o->cap.rad, ext = o->cap.ext;
+      v3 norm = o->cap.norm;
+      imod_add(lazy.cyl, m4_mul(m4_scale(r, ext, r), m4_trans_v(obj_snap_ipos(o, d))), o->id);
+      imod_add(lazy.ball, m4_mul(m4_scale(r, r, r), m4_trans_v(
+        v3_add(obj_snap_ipos(o, d), v3_mul(norm, ext)))), o->id);
+      imod_add(lazy.ball, m4_mul(m4_scale(r, r, r), m4_trans_v(
+        v3_add(obj_snap_ipos(o, d), v3_neg(v3_mul(norm, ext))))), o->id);
+#endif
+      break;
+    }
+    case ot_test: {
+      float r = o->ball.rad;
+      imod_add(lazy.ball,
+               m4_mul(m4_scale(r, r, r), m4_trans_v(obj_snap_ipos(o, d))), o->id);
+      break;
+    }
+    case ot_tree: {
+      tree *t = &o->tree;
+      int lod = n_trees *
+                (box3_dist(obj_get_box(o), cam_get_eye(c)) >
+                 36.f);
+
+      imod_add(lazy.leaves[t->idx + lod],
+               m4_mul(m4_mul(m4_rot_y(t->rot), m4_chg_axis(t->dir, 1)),
+                      m4_trans_v(v3_sub(o->pos, t->offset))), o->id);
+
+      imod_add(lazy.trunks[t->idx + lod],
+               m4_mul(m4_mul(m4_rot_y(t->rot), m4_chg_axis(t->dir, 1)),
+                      m4_trans_v(v3_sub(o->pos, t->offset))), o->id);
+      break;
+    }
+  }
+}
+
+box3 obj_get_box(obj_snap *o) {
+  lazy_init();
+  switch (o->type) {
+    case ot_hana: {
+      cap c = o->cap;
+      return box3_add(
+#ifdef NDEBUG
+        lazy.hana->bounds,
+#else
+        lazy.cyl->bounds,
+#endif
+                      v3_sub(o->pos, v3_mul(c.norm, c.ext + c.rad)));
+    }
+    case ot_tree: {
+      tree *t = &o->tree;
+      return box3_add(
+        box3_fit(lazy.trunks[t->idx]->bounds, lazy.leaves[t->idx]->bounds),
+        t->base);
+    }
+    case ot_test: {
+      float r = o->ball.rad;
+      return (box3){v3_sub(o->pos, (v3){r, r, r}), v3_add(o->pos, (v3){r, r, r})};
+    }
+  }
+}
+
+v3 obj_snap_ipos(obj_snap *o, float d) {
+  return v3_lerp(o->prev_pos, o->pos, d);
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "gl.h"
+#include "world.h"
+
+/*-- draws a world. kept apart from it so the world can run headless. --*/
+
+// the terrain is a toroidal grid of fixed chunk slots, chunk p lives in slot
+// p mod world_sp_size so visible chunks never collide
+#define view_n_slots (world_sp_size * world_sp_size)
+// lod level l draws every 2^l-th grid line, down to just the corners
+#define view_n_lods 4
+// chunks drop to lod level l + 1 past view_lod_range * 2^l, measured from
+// the camera's 3x3 chunk neighbourhood. res/terrain.glsl morphs vertices over
+// the last view_lod_morph of each range so levels swap without cracks.
+#define view_lod_range (6.f * chunk_sizef)
+#define view_lod_morph 0.25f
+
+// a chunk as the terrain shaders see it, std430 ter_slot in
+// res/terrain.glsl. x/z and the lod morph targets are rebuilt from the grid.
+typedef struct ter_slot {
+  iv2 pos;
+  int id, pad;
+  float h[chunk_len * chunk_len];
+  // octahedral snorm16x2, upper hemisphere only
+  u32 norm[chunk_len * chunk_len];
+} ter_slot;
+
+// what obj_draw needs of an obj, copied out of objs_tick every tick.
+typedef struct obj_snap {
+  union {
+    obj_type type;
+    hana hana;
+    tree tree;
+  };
+
+  int id;
+  // the body's shape, and where it was at the start and end of the tick
+  union {
+    cap cap;
+    ball ball;
+  };
+  v3 pos, prev_pos;
+} obj_snap;
+
+// a finished tick as the renderer sees it.
+typedef struct view_snap {
+  obj_snap *objs;
+  // every slot written since the last snapshot the renderer took, one
+  // ter_slot in slot_data each
+  int *slot_writes;
+  ter_slot *slot_data;
+  // base vertex and lod level of every slot to draw
+  int *slot_draws, *slot_lods;
+  // ticker_now() when it was published
+  int64_t time;
+  // counts up from 1 with every view_publish
+  unsigned seq;
+} view_snap;
+
+// snapshots are triple buffered: the tick thread fills back while the
+// renderer draws front, and they trade with the one in the middle
+#define view_n_snaps 3
+// set on the middle index when it holds a snapshot the renderer hasn't taken
+#define view_fresh 4
+
+typedef struct view {
+  // ssbo of view_n_slots ter_slots, the terrain shaders pull vertices from it
+  buf slots, ib;
+  vao va;
+  // index range of each lod level in ib
+  int lod_first[view_n_lods], lod_count[view_n_lods];
+
+  // the rest belongs to the tick thread, bar front.
+  // chunk each slot holds once published writes land
+  iv2 slot_pos[view_n_slots];
+  // what each slot was last packed with, and the seq of the snapshot that
+  // first carried it, 0 if never
+  ter_slot *slot_data;
+  unsigned slot_seq[view_n_slots];
+  // the draw lists as of the last view_publish
+  int *slot_draws, *slot_lods;
+  // what the draw lists were built from
+  iv2 last_center;
+  unsigned last_version;
+
+  view_snap snaps[view_n_snaps];
+  // back is only touched by the tick thread and front by the renderer
+  int back, front;
+  // the middle snapshot's index, or'd with view_fresh
+  int _Atomic mid;
+  // the seq of the last snapshot published, and of the last one the
+  // renderer took. slots written after taken are still in every snapshot,
+  // since the renderer may skip some
+  unsigned seq;
+  unsigned _Atomic taken;
+} view;
+
+// requires an opengl context!
+view *view_new();
+
+// snapshots w's objs and the terrain around center for the renderer. only
+// touches memory, so it runs on the tick thread and never waits.
+void view_publish(view *v, world *w, iv2 center);
+
+// the latest published snapshot, uploading its slot writes if it's new. the
+// renderer keeps it until its next view_take, however many ticks go by.
+view_snap *view_take(view *v);
+
+// culls snap's objs against c and queues the rest. nothing is drawn until
+// view_draw and imod_draw, so c can still be turned in between.
+void view_cull(view_snap *snap, draw_src s, cam *c, float d);
+
+// draws the terrain and the objs view_cull queued as whole mods.
+void view_draw(view *v, view_snap *snap, draw_src s, cam *c, float d);
+
+shdr *ch_get_sh(draw_src s, cam *c);
+
+void obj_draw(obj_snap *o, draw_src s, cam *c, float d);
+
+box3 obj_get_box(obj_snap *o);
+
+v3 obj_snap_ipos(obj_snap *o, float d);
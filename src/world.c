@@ -2,238 +2,372 @@
 #include "typedefs.h"
 #include "body.h"
 #include "map.h"
-#include "app.h"
+#include <limits.h>
+#include <stdatomic.h>
+#include "ticker.h"
 
 world *world_new(obj player) {
-  buf vb = buf_new(GL_ARRAY_BUFFER), ib = buf_new(GL_ELEMENT_ARRAY_BUFFER);
-
   auto w = _new_((world){
     .chunks = map_new(16, sizeof(iv2), sizeof(chunk), 0.5f, iv2_peq, iv2_hash),
-    .objs = arr_new(obj),
+    .gen = gen_new(rfile_store_new("save")),
     .objs_tick = arr_new(obj),
     .objs_to_add = arr_new(obj),
-    .draw_lock = PTHREAD_MUTEX_INITIALIZER,
-    .vb = vb,
-    .ib = ib,
-    .va = vao_new(&vb, &ib, 3, (attrib[]){attr_3f, attr_3f, attr_1i}),
-    .vb_dirty = 0,
+    .grid = grid_new(),
+    .pool = pool_new(),
+    .kin = kin_new(),
     .last_chunk_pos = (iv2){INT_MAX, INT_MAX},
-    .vb_cache = arr_new(ch_vtx),
-    .ib_cache = arr_new(int),
   });
 
   world_add_obj(w, &player);
 
+  // the player needs ground to land on before the first tick
 #ifdef NDEBUG
-  for (int i = -world_draw_dist; i <= world_draw_dist; i++) {
-    for (int j = -world_draw_dist; j <= world_draw_dist; j++) {
-      chunk c = chunk_new(w, (iv2){i, j});
-      map_add(&w->chunks, &(iv2){i, j}, &c);
+  int const pre = world_draw_dist;
+#else
+  int const pre = 1;
+#endif
+  for (int i = -pre; i <= pre; i++) {
+    for (int j = -pre; j <= pre; j++) {
+      gen_request(w->gen, (iv2){i, j});
     }
   }
-#endif
 
-  for (int i = 0; i < world_sp_size; i++) {
-    for (int j = 0; j < world_sp_size; j++) {
-      w->regions[i][j] = reg_new();
-    }
+  chunk ch;
+  while (gen_wait(w->gen, &ch)) {
+    world_add_chunk(w, &ch);
   }
 
   arr_add_bulk(&w->objs_tick, w->objs_to_add);
   arr_clear(w->objs_to_add);
-  arr_copy(&w->objs, w->objs_tick);
 
   return w;
 }
 
+static size_t chunk_mem(chunk *c) {
+  return sizeof(iv2) + sizeof(chunk) +
+    arr_len(c->body.height.h) * sizeof(*c->body.height.h);
+}
+
+void world_add_chunk(world *w, chunk *c) {
+  chunk_spawn(c, w);
+  c->proxy = grid_add_sta(&w->grid, &c->body, c->id);
+  c->last_seen = w->n_stream_passes;
+  w->chunk_mem += chunk_mem(c);
+  w->chunks_version++;
+  map_add(&w->chunks, &c->pos, c);
+}
+
 iv2 world_get_chunk_pos(v3 world_pos) {
   return (iv2){(int)floorf(world_pos.x / (float)chunk_size),
                (int)floorf(world_pos.z / (float)chunk_size)};
 }
 
-void world_tick(world *w, cam *c) {
-  // clear the reg partition
-  for (int i = 0; i < world_sp_size; i++) {
-    for (int j = 0; j < world_sp_size; j++) {
-      reg *s = &w->regions[i][j];
-      reg_clear(s);
-    }
-  }
+static void world_move(world *w, int h, body *b) {
+  kin_move(&w->kin, w->grid.proxies[h].kin, b);
+  grid_move(&w->grid, h, b, v3_mul(b->vel, (float)kin_base_steps));
+}
 
-  // handle all chunks
-  iv2 cam_pos = world_get_chunk_pos(c->pos);
-  for (int i = -world_draw_dist; i <= world_draw_dist; i++) {
-    for (int j = -world_draw_dist; j <= world_draw_dist; j++) {
-      if (sqrt(i * i + j * j) > world_draw_dist + 1) continue;
+// brings the bodies the grid woke into this tick
+static void world_wake(world *w) {
+  for (size_t i = 0; i < arr_len(w->grid.woken); i++) {
+    int h = w->grid.woken[i];
+    if (grid_is_moved(&w->grid, h)) continue;
 
-      iv2 chunk_pos = {cam_pos.x + i, cam_pos.y + j};
+    world_move(w, h, w->grid.proxies[h].dyn);
+  }
 
-      chunk *ch = map_at(&w->chunks, &chunk_pos);
-      if (!ch) continue;
+  arr_clear(w->grid.woken);
+}
 
-      reg *r = &w->regions[i + world_draw_dist][j + world_draw_dist];
+static double world_now() {
+  return (double)ticker_now() / 1e6;
+}
 
-      reg_add_sta(r, &ch->body);
-    }
-  }
+void world_tick(world *w, v3 center) {
+  tick_stats *st = &w->stats;
+  *st = (tick_stats){};
+  double t = world_now(), now;
 
-  // handle all objects
+  // statics stay where they were binned, only awake dynamic bodies move
+  grid_begin(&w->grid);
+  kin_begin(&w->kin);
   for (obj *o = w->objs_tick, *end = arr_end(w->objs_tick); o != end; o++) {
     body *b = &o->body;
-    b->prev_pos = b->pos;
-    b->on_ground = 0;
-    box3 bounds = body_get_box(b);
-    iv2 chunk_min = world_get_chunk_pos(bounds.min),
-      chunk_max = world_get_chunk_pos(bounds.max);
-    iv2 min = iv2_sub(chunk_min, cam_pos),
-      max = iv2_sub(chunk_max, cam_pos);
-
-    for (int i = min.x; i <= max.x; i++) {
-      for (int j = min.y; j <= max.y; j++) {
-        if (abs(i) <= world_draw_dist &&
-            abs(j) <= world_draw_dist) {
-          reg *r = &w->regions[i + world_draw_dist][j + world_draw_dist];
-          (o->dynamic ? reg_add_dyn : reg_add_sta)(r, b);
-        }
-      }
+    // statics never move, and kin sets prev_pos for the rest
+    if (!o->dynamic) {
+      if (!o->proxy) o->proxy = grid_add_sta(&w->grid, b, o->id);
+      continue;
     }
-  }
-
-  // tick each physics region
-  int const sub_steps = 4;
-  float const step_time = 1.f / (float)sub_steps;
 
-  for (int t = 0; t < sub_steps; t++) {
-    for (obj *o = w->objs_tick, *end = arr_end(w->objs_tick); o != end; o++) {
-      if (!o->dynamic || v3_dist(o->body.pos, c->pos) > (world_draw_dist + 1) * chunk_size)
-        continue;
-
-      body_tick(&o->body, step_time);
+    if (!o->proxy) {
+      o->proxy = grid_add_dyn(&w->grid, b, o->id, kin_add(&w->kin, b));
     }
 
-    for (int i = 0; i < world_sp_size; i++) {
-      for (int j = 0; j < world_sp_size; j++) {
-        reg *s = &w->regions[i][j];
-        if (!reg_is_tickable(s)) continue;
+    grid_track(&w->grid, o->proxy, b);
+    kin_track(&w->kin, w->grid.proxies[o->proxy].kin, b);
+    // something pushed it since it fell asleep
+    if (grid_is_asleep(&w->grid, o->proxy) &&
+        v3_len(b->vel) >= grid_sleep_speed) {
+      grid_wake(&w->grid, o->proxy);
+    }
 
-        reg_tick(s);
-      }
+    if (!grid_is_asleep(&w->grid, o->proxy) &&
+        !grid_is_moved(&w->grid, o->proxy)) {
+      world_move(w, o->proxy, b);
     }
   }
 
+  // island members earlier in objs_tick might have been woken since
+  world_wake(w);
+  while (grid_pairs(&w->grid)) world_wake(w);
+  kin_plan(&w->kin);
+  st->broad = (float)((now = world_now()) - t), t = now;
+
+  // the substeps only touch kin and the bodies in pairs. each body steps as
+  // often as its speed needs, so most take one
+  for (int s = 0; s < w->kin.n_steps; s++) {
+    grid_sweep(&w->grid, &w->kin, s);
+    kin_integrate(&w->kin, s, center, (world_draw_dist + 1) * chunk_size);
+    st->integrate += (float)((now = world_now()) - t), t = now;
+
+    grid_solve(&w->grid, w->pool, &w->kin, s);
+    st->solve += (float)((now = world_now()) - t), t = now;
+  }
+
+  kin_flush(&w->kin);
+  grid_settle(&w->grid);
+  st->settle = (float)((now = world_now()) - t), t = now;
+  st->n_moved = (int)arr_len(w->grid.active);
+  st->n_pairs = (int)arr_len(w->grid.pairs);
+  st->n_steps = w->kin.n_steps;
+
   // tick all game objects
   for (obj *o = w->objs_tick, *end = arr_end(w->objs_tick); o != end; o++) {
     body *b = &o->body;
-    if (v3_dist(b->pos, c->pos) > world_draw_dist * chunk_size) {
+    if (v3_dist(b->pos, center) > world_draw_dist * chunk_size) {
       continue;
     }
 
     obj_tick(o);
   }
+
+  st->objs = (float)(world_now() - t);
 }
 
-void world_cache(world *w, iv2 cam_to_chunk) {
-#define n_inds (chunk_qty * chunk_qty* 6)
-  static int qinds[n_inds], first_run = 1;
-  if (first_run) {
-    int *rinds = quad_indices(chunk_len, chunk_len);
-    memcpy(qinds, rinds, sizeof(qinds));
-    first_run = 0;
+void world_stream(world *w, iv2 center) {
+  bool moved = !iv2_eq(w->last_chunk_pos, center);
+  if (moved) {
+    gen_recenter(w->gen, center, world_draw_dist + 1);
   }
 
-  static int last_nc = 0;
+  // finished chunks trickle in under a budget so a burst can't stall the tick
+  int n_new = 0;
+  chunk ch;
+  while (n_new < world_gen_budget && gen_poll(w->gen, &ch)) {
+    world_add_chunk(w, &ch);
+    n_new++;
+  }
+
+  if (moved) {
+    world_evict(w, center);
+  }
 
-  if (!iv2_eq(w->last_chunk_pos, cam_to_chunk)) {
-    arr_clear(w->vb_cache);
-    int nc = 0;
+  if (moved || n_new) {
+    w->n_stream_passes++;
 
     for (int i = -world_draw_dist; i <= world_draw_dist; i++) {
       for (int j = -world_draw_dist; j <= world_draw_dist; j++) {
         float dist = sqrtf(i * i + j * j);
         if (dist > world_draw_dist + 1) continue;
-        nc++;
 
-        iv2 chunk_pos = {cam_to_chunk.x + i, cam_to_chunk.y + j};
+        iv2 chunk_pos = {center.x + i, center.y + j};
 
-        chunk *ch = map_at(&w->chunks, &chunk_pos);
+        chunk *c = map_at(&w->chunks, &chunk_pos);
 
-        if (!ch) {
-          chunk gen = chunk_new(w, chunk_pos);
-          ch = map_add(&w->chunks, &chunk_pos, &gen);
+        // not generated yet, skip it until it shows up
+        if (!c) {
+          gen_request(w->gen, chunk_pos);
+          continue;
         }
 
-        arr_add_arr(&w->vb_cache, ch->data, chunk_len * chunk_len,
-                    sizeof(ch_vtx));
+        c->last_seen = w->n_stream_passes;
       }
     }
 
-    if (nc > last_nc) {
-      for (int i = last_nc; i < nc; i++) {
-        for (int j = 0; j < n_inds; j++) {
-          arr_add(&w->ib_cache, &(int){qinds[j] + i * (chunk_len * chunk_len)});
-        }
-      }
+    w->last_chunk_pos = center;
+  }
+}
 
-      w->ib_dirty = 1;
-    }
+typedef struct evict_cand {
+  iv2 pos;
+  unsigned last_seen;
+} evict_cand;
 
-    last_nc = nc;
+static int evict_cand_cmp(void const *a, void const *b) {
+  unsigned x = ((evict_cand const *)a)->last_seen,
+    y = ((evict_cand const *)b)->last_seen;
+  return (x > y) - (x < y);
+}
 
-    w->last_chunk_pos = cam_to_chunk;
-    w->vb_dirty = 1;
+void world_evict(world *w, iv2 center) {
+  static evict_cand *cands = NULL;
+  static iv2 *gone = NULL;
+  static int *tree_ids = NULL;
+  if (!cands) {
+    cands = arr_new(evict_cand);
+    gone = arr_new(iv2);
+    tree_ids = arr_new(int);
   }
-#undef n_inds
-}
 
-void world_draw(world *w, draw_src s, cam *c, float d) {
-  ch_get_sh(s, c);
+  arr_clear(cands);
+  arr_clear(gone);
+  arr_clear(tree_ids);
+
+  iv2 *keys = w->chunks.keys;
+  chunk *vals = w->chunks.vals;
+  size_t mem = w->chunk_mem;
+  for (size_t i = 0; i < w->chunks.count; i++) {
+    iv2 d = iv2_sub(keys[i], center);
+    if (abs(d.x) > world_keep_dist || abs(d.y) > world_keep_dist) {
+      arr_add(&gone, &keys[i]);
+      mem -= chunk_mem(&vals[i]);
+    } else if (sqrtf(d.x * d.x + d.y * d.y) > world_draw_dist + 1) {
+      arr_add(&cands, &(evict_cand){keys[i], vals[i].last_seen});
+    }
+  }
 
-  if (w->vb_dirty) {
-    buf_data_n(&w->vb, GL_DYNAMIC_DRAW, sizeof(ch_vtx), arr_len(w->vb_cache),
-               w->vb_cache);
-    w->vb_dirty = 0;
+  // over budget: the chunks that left the view longest ago go first
+  if (mem > world_chunk_budget) {
+    qsort(cands, arr_len(cands), sizeof(evict_cand), evict_cand_cmp);
+    for (evict_cand *e = cands, *end = arr_end(cands);
+         e != end && mem > world_chunk_budget; e++) {
+      arr_add(&gone, &e->pos);
+      mem -= chunk_mem(map_at(&w->chunks, &e->pos));
+    }
   }
 
-  if (w->ib_dirty) {
-    buf_data_n(&w->ib, GL_DYNAMIC_DRAW, sizeof(int), arr_len(w->ib_cache),
-               w->ib_cache);
-    w->ib_dirty = 0;
+  if (arr_is_empty(gone)) return;
+
+  for (iv2 *p = gone, *end = arr_end(gone); p != end; p++) {
+    chunk *c = map_at(&w->chunks, p);
+    if (c->tree_id >= 0) arr_add(&tree_ids, &c->tree_id);
+    grid_remove(&w->grid, c->proxy);
+    chunk_del(c);
+    map_remove(&w->chunks, p);
+    gen_forget(w->gen, *p);
   }
+  w->chunk_mem = mem;
+  w->chunks_version++;
+
+  if (arr_is_empty(tree_ids)) return;
+
+  // trees might still be waiting in objs_to_add
+  obj **lists[] = {&w->objs_tick, &w->objs_to_add};
+  for (int l = 0; l < 2; l++) {
+    obj *objs = *lists[l];
+    for (size_t i = 0; i < arr_len(objs);) {
+      bool hit = 0;
+      for (int *t = tree_ids, *end = arr_end(tree_ids); t != end; t++) {
+        if (objs[i].id == *t) {
+          hit = 1;
+          break;
+        }
+      }
 
-  vao_bind(&w->va);
-  size_t n_inds = arr_len(w->ib_cache);
-  gl_draw_elements(GL_TRIANGLES, n_inds, GL_UNSIGNED_INT, 0);
-  $.n_tris += n_inds / 3;
+      if (!hit) {
+        i++;
+        continue;
+      }
 
-  $.n_drawn = $.n_close = 0;
+      if (objs[i].proxy) {
+        if (objs[i].dynamic) {
+          kin_remove(&w->kin, w->grid.proxies[objs[i].proxy].kin);
+        }
+        grid_remove(&w->grid, objs[i].proxy);
+      }
 
-  for (obj *o = w->objs, *end = arr_end(w->objs); o != end; o++) {
-    body *b = &o->body;
-    if (v3_dist(b->pos, c->pos) > (world_draw_dist + 1) * chunk_size) {
-      continue;
+      // order doesn't matter past the player in slot 0
+      objs[i] = *arr_last(objs);
+      arr_len(objs)--;
     }
+  }
+}
+
+void world_add_obj(world *w, obj *o) {
+  o->body.prev_pos = o->body.pos;
+  o->world = w;
+  o->id = w->id++;
+  arr_add(&w->objs_to_add, o);
+}
+// the grid and kin point at dynamic bodies, which move whenever objs_tick
+// grows
+static void world_sync(world *w) {
+  for (obj *o = w->objs_tick, *end = arr_end(w->objs_tick); o != end; o++) {
+    if (!o->dynamic || !o->proxy) continue;
 
-    $.n_close++;
+    grid_track(&w->grid, o->proxy, &o->body);
+    kin_track(&w->kin, w->grid.proxies[o->proxy].kin, &o->body);
+  }
+}
 
-    if (!cam_test_box(&$.cam, obj_get_box(o), s)) {
-      continue;
+// queries are handed out to workers this many at a time
+#define world_cast_run 32
+
+typedef struct cast_job {
+  grid *grid;
+  query const *qs;
+  query_hit *out;
+  int _Atomic next;
+  int n;
+} cast_job;
+
+static void world_cast_job(void *ctx, int worker) {
+  cast_job *job = ctx;
+  for (int first; (first = atomic_fetch_add(&job->next, world_cast_run)) <
+                  job->n;) {
+    for (int i = first, end = min(first + world_cast_run, job->n); i < end;
+         i++) {
+      query const *q = &job->qs[i];
+      int h;
+      ray_hit hit = grid_cast(job->grid, q->o, q->d, q->l, q->rad, q->ignore,
+                              &h);
+
+      job->out[i] = hit.is_hit ? (query_hit){
+        .is_hit = 1,
+        .t = hit.t,
+        .pos = v3_add(q->o, v3_mul(q->d, hit.t)),
+        .norm = hit.norm,
+        .id = job->grid->proxies[h].id,
+      } : (query_hit){};
     }
+  }
+}
 
-    $.n_drawn++;
+void world_cast(world *w, query const *qs, query_hit *out, int n) {
+  world_sync(w);
 
-    obj_draw(o, s, c, d);
+  cast_job job = {.grid = &w->grid, .qs = qs, .out = out, .n = n};
+  if (n <= world_cast_run) {
+    world_cast_job(&job, 0);
+    return;
   }
+
+  pool_run(w->pool, world_cast_job, &job);
 }
 
-int world_raycast(world *w, v3 o, v3 d, float l) {
-  for (obj *e = w->objs, *end = arr_end(e); e != end; e++) {
-//    obj_raycast(e,)
-  }
+query_hit world_raycast(world *w, v3 o, v3 d, float l) {
+  query_hit out;
+  world_cast(w, &(query){.o = o, .d = d, .l = l}, &out, 1);
+  return out;
 }
 
-void world_add_obj(world *w, obj *o) {
-  o->body.prev_pos = o->body.pos;
-  o->world = w;
-  o->id = w->id++;
-  arr_add(&w->objs_to_add, o);
-}
\ No newline at end of file
+void world_overlap(world *w, box3 box, int **ids) {
+  world_sync(w);
+
+  int *hs = arr_new(int);
+  grid_overlap(&w->grid, box, &hs);
+  for (size_t i = 0; i < arr_len(hs); i++) {
+    arr_add(ids, &w->grid.proxies[hs[i]].id);
+  }
+  arr_del(hs);
+}
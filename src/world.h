@@ -1,46 +1,103 @@
 #pragma once
 
-#include <pthread.h>
-#include "gl.h"
 #include "lib/simplex/FastNoiseLite.h"
 #include "arr.h"
 #include "map.h"
-#include "reg.h"
+#include "grid.h"
 #include "map.h"
 #include "chunk.h"
 #include "obj.h"
+#include "gen.h"
 
 /*-- a 3d world using simplex noise. --*/
 
 #define world_draw_dist 24
 #define world_sp_size (world_draw_dist * 2 + 1)
+// max generated chunks moved into the world per tick
+#define world_gen_budget 16
+// chunks further than this are always evicted
+#define world_keep_dist (world_draw_dist * 2)
+// bytes of chunk data kept before the least recently in range are evicted
+#define world_chunk_budget ((size_t)64 << 20)
+
+// what the last world_tick spent its time on, in ms
+typedef struct tick_stats {
+  // binning moved bodies and finding pairs
+  float broad;
+  // sweeping fast bodies and integrating kin
+  float integrate;
+  // narrowphase and response
+  float solve;
+  // copying kin out and putting islands to sleep
+  float settle;
+  float objs;
+  int n_moved, n_pairs, n_steps;
+} tick_stats;
 
 typedef struct world {
   // iv2 -> chunk
   map chunks;
-  reg regions[world_sp_size][world_sp_size];
-
-  obj *objs, *objs_tick, *objs_to_add;
-  buf vb, ib;
-  vao va;
-  ch_vtx *vb_cache;
-  int *ib_cache;
-  bool vb_dirty, ib_dirty;
+  gen *gen;
+  grid grid;
+  // solves the grid's colors across cores
+  pool *pool;
+  // motion of the dynamic bodies while ticking
+  kin kin;
+  tick_stats stats;
+
+  obj *objs_tick, *objs_to_add;
+  ctrl ctrl;
+  unsigned n_stream_passes;
+  // bumped whenever a chunk is added or evicted
+  unsigned chunks_version;
+  size_t chunk_mem;
   iv2 last_chunk_pos;
 
-  pthread_mutex_t draw_lock;
   int _Atomic id;
 } world;
 
-// requires an opengl context!
+// never touches gl, rendering lives in view.h.
 world *world_new(obj player);
 
+// takes ownership of c's collider and spawns its trees.
+void world_add_chunk(world *w, chunk *c);
+
 iv2 world_get_chunk_pos(v3 world_pos);
 
-void world_tick(world *w, cam *c);
+// ticks everything within world_draw_dist chunks of center.
+void world_tick(world *w, v3 center);
+
+// moves generated chunks in and requests the missing ones around center.
+void world_stream(world *w, iv2 center);
+
+// drops chunks outside world_keep_dist, then the least recently in range ones
+// until chunk_mem fits world_chunk_budget. visible chunks are never dropped.
+void world_evict(world *w, iv2 center);
+
+void world_add_obj(world *w, obj *o);
+
+// a ray, or a ball of radius rad swept along one.
+typedef struct query {
+  // from o along the unit dir d, for up to l
+  v3 o, d;
+  float l, rad;
+  // the grid handle of a body to skip, like the caster's own. 0 for none
+  int ignore;
+} query;
+
+typedef struct query_hit {
+  bool is_hit;
+  float t;
+  v3 pos, norm;
+  // of the obj or chunk hit
+  int id;
+} query_hit;
 
-void world_cache(world *w, iv2 cam_to_chunk);
+// answers n queries into out at once, spread across the pool. only call it
+// from the thread that ticks w.
+void world_cast(world *w, query const *qs, query_hit *out, int n);
 
-void world_draw(world *w, draw_src s, cam *c, float d);
+query_hit world_raycast(world *w, v3 o, v3 d, float l);
 
-void world_add_obj(world *w, obj *o);
\ No newline at end of file
+// adds the ids of the objs and chunks that overlap box to the arr ids.
+void world_overlap(world *w, box3 box, int **ids);
\ No newline at end of file